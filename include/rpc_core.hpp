@@ -4,10 +4,15 @@
 #include "rpc_core/serialize.hpp"
 
 // other include
+#include "rpc_core/arena.hpp"
 #include "rpc_core/connection.hpp"
 #include "rpc_core/dispose.hpp"
 #include "rpc_core/request.hpp"
 #include "rpc_core/rpc.hpp"
+#include "rpc_core/rpc_pool.hpp"
+#if !defined(RPC_CORE_SERIALIZE_USE_CUSTOM) && !defined(RPC_CORE_SERIALIZE_USE_NLOHMANN_JSON)
+#include "rpc_core/stream.hpp"
+#endif
 
 // impl
 #include "rpc_core/request.ipp"
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "detail/noncopyable.hpp"
+
+#ifdef RPC_CORE_FEATURE_THREAD_SAFE
+#define RPC_CORE_DETAIL_THREAD_LOCAL thread_local
+#else
+#define RPC_CORE_DETAIL_THREAD_LOCAL
+#endif
+
+namespace rpc_core {
+
+/**
+ * Monotonic bump allocator, memory is released all at once by reset(), blocks are kept for reuse.
+ * Containers use it by arena_allocator, which binds to the arena of the enclosing arena::scope on construction.
+ */
+class arena : detail::noncopyable {
+ public:
+  /**
+   * Set current arena during its lifetime, the arena is reset when the outermost scope of it exits.
+   * Objects allocated from the arena should be destroyed before that.
+   * @param a nullptr means no-op
+   */
+  class scope : detail::noncopyable {
+   public:
+    explicit scope(arena* a) : arena_(a), prev_(current()) {
+      if (arena_) {
+        ++arena_->depth_;
+        current() = arena_;
+      }
+    }
+
+    ~scope() {
+      if (arena_) {
+        current() = prev_;
+        if (--arena_->depth_ == 0) {
+          arena_->reset();
+        }
+      }
+    }
+
+   private:
+    arena* arena_;
+    arena* prev_;
+  };
+
+ public:
+  explicit arena(size_t block_size = 4096) : block_size_(block_size) {}
+
+  ~arena() {
+    for (auto& b : blocks_) {
+      ::operator delete(b.data);
+    }
+  }
+
+  void* allocate(size_t size, size_t align) {
+    while (index_ < blocks_.size()) {
+      auto& b = blocks_[index_];
+      const uintptr_t begin = (uintptr_t)b.data + used_;
+      const uintptr_t p = (begin + align - 1) & ~(uintptr_t)(align - 1);
+      if (p + size <= (uintptr_t)b.data + b.size) {
+        used_ = p + size - (uintptr_t)b.data;
+        return (void*)p;
+      }
+      ++index_;
+      used_ = 0;
+    }
+    const size_t block_size = size + align > block_size_ ? size + align : block_size_;
+    blocks_.push_back(block{::operator new(block_size), block_size});
+    return allocate(size, align);
+  }
+
+  /**
+   * O(1), keep blocks for next use
+   */
+  inline void reset() {
+    index_ = 0;
+    used_ = 0;
+  }
+
+  /**
+   * true if it is current arena of some scope, reset or destroy it is not safe
+   */
+  inline bool in_scope() const {
+    return depth_ > 0;
+  }
+
+  inline size_t block_count() const {
+    return blocks_.size();
+  }
+
+  static arena*& current() {
+    static RPC_CORE_DETAIL_THREAD_LOCAL arena* a = nullptr;
+    return a;
+  }
+
+ private:
+  struct block {
+    void* data;
+    size_t size;
+  };
+  size_t block_size_;
+  std::vector<block> blocks_;
+  size_t index_ = 0;
+  size_t used_ = 0;
+  uint32_t depth_ = 0;
+};
+
+/**
+ * STL allocator from arena::current() when constructed, or from heap when there is no current arena.
+ * deallocate() of arena memory is no-op.
+ * Containers from an arena and their moves should not outlive its scope, copy them to keep.
+ */
+template <typename T>
+class arena_allocator {
+ public:
+  using value_type = T;
+
+  arena_allocator() noexcept : arena_(arena::current()) {}
+
+  /**
+   * @param a nullptr means heap
+   */
+  explicit arena_allocator(arena* a) noexcept : arena_(a) {}
+
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& other) noexcept : arena_(other.arena_) {}  // NOLINT
+
+  T* allocate(size_t n) {
+    if (arena_) {
+      return (T*)arena_->allocate(n * sizeof(T), alignof(T));
+    }
+    return (T*)::operator new(n * sizeof(T));
+  }
+
+  void deallocate(T* p, size_t) noexcept {
+    if (!arena_) {
+      ::operator delete(p);
+    }
+  }
+
+  /**
+   * copy is allocated from heap, so it can be kept after the arena is reset, move keeps the arena
+   */
+  arena_allocator select_on_container_copy_construction() const noexcept {
+    return arena_allocator(nullptr);
+  }
+
+  template <typename U>
+  bool operator==(const arena_allocator<U>& other) const noexcept {
+    return arena_ == other.arena_;
+  }
+
+  template <typename U>
+  bool operator!=(const arena_allocator<U>& other) const noexcept {
+    return arena_ != other.arena_;
+  }
+
+ private:
+  template <typename U>
+  friend class arena_allocator;
+
+  arena* arena_;
+};
+
+/**
+ * Same as std::string/std::vector/std::map on wire
+ */
+using arena_string = std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+
+template <typename T>
+using arena_vector = std::vector<T, arena_allocator<T>>;
+
+template <typename K, typename V, typename Compare = std::less<K>>
+using arena_map = std::map<K, V, Compare, arena_allocator<std::pair<const K, V>>>;
+
+}  // namespace rpc_core
@@ -9,7 +9,9 @@
 
 // include
 #include "detail/data_packer.hpp"
+#include "detail/lock.hpp"
 #include "detail/noncopyable.hpp"
+#include "detail/string_view.hpp"
 
 namespace rpc_core {
 
@@ -19,10 +21,33 @@ namespace rpc_core {
  * 1. Both sending and receiving should ensure that a complete package of data is sent/received.
  * 2. Call on_recv_package when a package of data is actually received.
  * 3. Provide the implementation of sending data, send_package_impl.
+ * 4. Optional: call on_recv_package_view instead of on_recv_package to avoid copy.
+ * 5. Optional: provide send_package_iov_impl for transports support writev/sendmsg.
+ * 6. Optional: call on_recv_begin/on_recv_end around the packages of one read, for batch response.
  */
 struct connection : detail::noncopyable {
   std::function<void(std::string)> send_package_impl;
+  /**
+   * Scatter/gather alternative of send_package_impl, has higher priority.
+   * One package is split into segments, the segments are only valid during the call.
+   */
+  std::function<void(const detail::string_view *segments, size_t count)> send_package_iov_impl;
   std::function<void(std::string)> on_recv_package;
+  /**
+   * Zero-copy alternative of on_recv_package, set by rpc as well.
+   * The data is only used during the call, so it can point into the transport's buffer.
+   */
+  std::function<void(const detail::string_view &)> on_recv_package_view;
+  /**
+   * Set by rpc, responses produced between them can be sent as one package, see rpc::set_batch_response.
+   */
+  std::function<void()> on_recv_begin;
+  std::function<void()> on_recv_end;
+  /**
+   * Guards the outbound queue of rpc, send impl is called by one thread at a time, so packages from different threads
+   * do not interleave. It is not held during the send impl. No-op without RPC_CORE_FEATURE_THREAD_SAFE.
+   */
+  detail::mutex send_mutex;
 };
 
 /**
@@ -36,6 +61,9 @@ struct default_connection : connection {
     on_recv_package = [](const std::string &payload) {
       RPC_CORE_LOGE("need on_recv_package: %zu", payload.size());
     };
+    on_recv_package_view = [](const detail::string_view &payload) {
+      RPC_CORE_LOGE("need on_recv_package_view: %zu", payload.size());
+    };
   }
 };
 
@@ -65,14 +93,23 @@ struct loopback_connection : public connection {
 struct stream_connection : public connection {
   explicit stream_connection(uint32_t max_body_size = UINT32_MAX) : data_packer_(max_body_size) {
     send_package_impl = [this](const std::string &package) {
-      auto payload = data_packer_.pack(package);
-      send_bytes_impl(std::move(payload));
+      detail::string_view segment(package);
+      send_segments(&segment, 1);
+    };
+    send_package_iov_impl = [this](const detail::string_view *segments, size_t count) {
+      send_segments(segments, count);
     };
-    data_packer_.on_data = [this](std::string payload) {
-      on_recv_package(std::move(payload));
+    data_packer_.on_data_view = [this](const detail::string_view &payload) {
+      if (on_recv_package_view) {
+        on_recv_package_view(payload);
+      } else {
+        on_recv_package(std::string(payload.data(), payload.size()));
+      }
     };
     on_recv_bytes = [this](const void *data, size_t size) {
+      if (on_recv_begin) on_recv_begin();
       data_packer_.feed(data, size);
+      if (on_recv_end) on_recv_end();
     };
   }
 
@@ -81,14 +118,155 @@ struct stream_connection : public connection {
    */
   void reset() {
     data_packer_.reset();
+    detail::lock_guard lock(coalesce_mutex_);
+    coalesce_buffer_.clear();
+    coalesce_frames_ = 0;
+  }
+
+  /**
+   * Write coalescing, disabled by default.
+   * Packages are appended to a reusable buffer and sent in one send_bytes_impl/send_bytes_iov_impl call when:
+   * 1. flush() is called
+   * 2. buffered bytes >= max_bytes or buffered packages >= max_frames
+   * 3. the flush posted by post_flush_impl runs, usually at the end of the current event-loop tick
+   * flush() can be called from any thread, only one of them sends at a time and the others leave the buffer to it.
+   */
+  void set_coalesce(bool enable, size_t max_bytes = 64 * 1024, uint32_t max_frames = 64) {
+    if (!enable) {
+      flush();
+    }
+    coalesce_ = enable;
+    coalesce_max_bytes_ = max_bytes;
+    coalesce_max_frames_ = max_frames;
+  }
+
+  void flush() {
+    {
+      detail::lock_guard lock(coalesce_mutex_);
+      if (flushing_ || coalesce_buffer_.empty()) return;
+      flushing_ = true;
+    }
+    std::string buffer;
+    for (;;) {
+      {
+        detail::lock_guard lock(coalesce_mutex_);
+        if (coalesce_buffer_.empty()) {
+          flushing_ = false;
+          // reuse the buffer
+          if (buffer.capacity() > coalesce_buffer_.capacity()) {
+            buffer.clear();
+            buffer.swap(coalesce_buffer_);
+          }
+          return;
+        }
+        buffer.clear();
+        buffer.swap(coalesce_buffer_);
+        stats_.flush_count++;
+        stats_.frame_count += coalesce_frames_;
+        stats_.byte_count += buffer.size();
+        if (coalesce_frames_ > stats_.max_frames_per_flush) {
+          stats_.max_frames_per_flush = coalesce_frames_;
+        }
+        coalesce_frames_ = 0;
+      }
+      // packages sent during the call are sent by next round
+      if (send_bytes_iov_impl) {
+        detail::string_view segment(buffer);
+        send_bytes_iov_impl(&segment, 1);
+      } else {
+        send_bytes_impl(std::move(buffer));
+      }
+    }
+  }
+
+  struct coalesce_stats {
+    uint64_t flush_count = 0;
+    uint64_t frame_count = 0;
+    uint64_t byte_count = 0;
+    uint32_t max_frames_per_flush = 0;
+
+    double frames_per_flush() const {
+      return flush_count ? (double)frame_count / (double)flush_count : 0;
+    }
+  };
+
+  coalesce_stats stats() const {
+    detail::lock_guard lock(coalesce_mutex_);
+    return stats_;
+  }
+
+  void reset_stats() {
+    detail::lock_guard lock(coalesce_mutex_);
+    stats_ = {};
+  }
+
+ private:
+  void send_segments(const detail::string_view *segments, size_t count) {
+    if (coalesce_) {
+      bool need_flush;
+      bool need_post = false;
+      {
+        detail::lock_guard lock(coalesce_mutex_);
+        bool packed = data_packer_.pack(segments, count, [this](const detail::string_view *iov, size_t iov_count) {
+          for (size_t i = 0; i < iov_count; ++i) {
+            coalesce_buffer_.append(iov[i].data(), iov[i].size());
+          }
+        });
+        if (!packed) return;
+        ++coalesce_frames_;
+        need_flush = coalesce_buffer_.size() >= coalesce_max_bytes_ || coalesce_frames_ >= coalesce_max_frames_;
+        if (!need_flush && post_flush_impl && !flush_posted_) {
+          flush_posted_ = true;
+          need_post = true;
+        }
+      }
+      if (need_flush) {
+        flush();
+      } else if (need_post) {
+        post_flush_impl([this] {
+          {
+            detail::lock_guard lock(coalesce_mutex_);
+            flush_posted_ = false;
+          }
+          flush();
+        });
+      }
+    } else if (send_bytes_iov_impl) {
+      data_packer_.pack(segments, count, send_bytes_iov_impl);
+    } else {
+      send_bytes_impl(data_packer_.pack(segments, count));
+    }
   }
 
  public:
   std::function<void(std::string)> send_bytes_impl;
+  /**
+   * Optional, like writev, has higher priority than send_bytes_impl.
+   * The segments are only valid during the call.
+   */
+  std::function<void(const detail::string_view *segments, size_t count)> send_bytes_iov_impl;
   std::function<void(const void *data, size_t size)> on_recv_bytes;
+  /**
+   * Optional, for write coalescing: run flush later on the event loop, e.g. asio::post
+   * the connection should be alive when flush runs
+   */
+  std::function<void(std::function<void()> flush)> post_flush_impl;
 
  private:
   detail::data_packer data_packer_;
+
+  bool coalesce_ = false;
+  size_t coalesce_max_bytes_ = 0;
+  uint32_t coalesce_max_frames_ = 0;
+  std::string coalesce_buffer_;
+  uint32_t coalesce_frames_ = 0;
+  bool flush_posted_ = false;
+  bool flushing_ = false;
+  coalesce_stats stats_;
+  /**
+   * guard coalescing state, the loop thread flushes while other threads send
+   */
+  mutable detail::mutex coalesce_mutex_;
 };
 
 }  // namespace rpc_core
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../type.hpp"
+#include "string_view.hpp"
+
+namespace rpc_core {
+namespace detail {
+
+/**
+ * cmd_len in header equal to CmdIdMark means the cmd is sent as cmd id
+ */
+static const uint16_t CmdIdMark = 0xffff;
+
+/**
+ * cmd id is the FNV-1a hash of cmd, both sides can get the same id without handshake
+ */
+inline cmd_id_type make_cmd_id(const string_view& cmd) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < cmd.size(); ++i) {
+    hash ^= (uint8_t)cmd.data()[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace detail
+}  // namespace rpc_core
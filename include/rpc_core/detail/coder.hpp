@@ -3,50 +3,99 @@
 #ifdef RPC_CORE_FEATURE_CODER_VARINT
 #include "coder_varint.hpp"
 #else
+#include "cmd_id.hpp"
+#include "endian.hpp"
+#include "log.h"
 #include "msg_wrapper.hpp"
 
 namespace rpc_core {
 namespace detail {
 
+/**
+ * Fixed layout, all fields little endian:
+ * seq(4) cmd_len(2) [cmd_id(4) if cmd_len == CmdIdMark | cmd(cmd_len)] type(1) payload
+ */
 class coder {
  public:
+  /**
+   * segments of a serialized msg: header(seq, cmd_len[, cmd_id]), cmd, type, payload
+   * cmd, type and payload point into msg, so msg should outlive it
+   */
+  struct iov_buffer {
+    static const uint8_t Count = 4;
+    char header[10];
+    detail::string_view segments[Count];
+  };
+
+  /**
+   * @return false if cmd is too long, its length would be read as CmdIdMark
+   */
+  static bool serialize(const msg_wrapper& msg, iov_buffer& iov) {
+    if (!msg.with_cmd_id && msg.cmd.length() >= CmdIdMark) {
+      RPC_CORE_LOGE("cmd too long: %zu", msg.cmd.length());
+      return false;
+    }
+    store_le<uint32_t>(iov.header, msg.seq);
+    if (msg.with_cmd_id) {
+      store_le<uint16_t>(iov.header + 4, CmdIdMark);
+      store_le<uint32_t>(iov.header + 6, msg.cmd_id);
+      iov.segments[0] = detail::string_view(iov.header, 10);
+      iov.segments[1] = detail::string_view();
+    } else {
+      auto cmd_len = (uint16_t)msg.cmd.length();
+      store_le<uint16_t>(iov.header + 4, cmd_len);
+      iov.segments[0] = detail::string_view(iov.header, 6);
+      iov.segments[1] = detail::string_view(msg.cmd.data(), cmd_len);
+    }
+    iov.segments[2] = detail::string_view((char*)&msg.type, 1);
+    iov.segments[3] = msg.request_payload ? detail::string_view(*msg.request_payload) : detail::string_view(msg.data);
+    return true;
+  }
+
   static std::string serialize(const msg_wrapper& msg) {
+    iov_buffer iov;
     std::string payload;
-    payload.reserve(PayloadMinLen + msg.cmd.size() + msg.data.size());
-    payload.append((char*)&msg.seq, 4);
-    auto cmd_len = (uint16_t)msg.cmd.length();
-    payload.append((char*)&cmd_len, 2);
-    payload.append((char*)msg.cmd.data(), cmd_len);
-    payload.append((char*)&msg.type, 1);
-    if (msg.request_payload) {
-      payload.append(*msg.request_payload);
-    } else {
-      payload.append(msg.data);
+    if (!serialize(msg, iov)) {
+      return payload;
+    }
+    payload.reserve(iov.segments[0].size() + iov.segments[1].size() + 1 + iov.segments[3].size());
+    for (const auto& seg : iov.segments) {
+      payload.append(seg.data(), seg.size());
     }
     return payload;
   }
 
-  static msg_wrapper deserialize(const std::string& payload, bool& ok) {
+  /**
+   * nothing is copied, cmd_view and data_view point into payload, so payload should outlive the returned msg
+   */
+  static msg_wrapper deserialize(const detail::string_view& payload, bool& ok) {
     msg_wrapper msg;
+    ok = false;
     if (payload.size() < PayloadMinLen) {
-      ok = false;
       return msg;
     }
-    char* p = (char*)payload.data();
-    const char* pend = payload.data() + payload.size();
-    msg.seq = *(seq_type*)p;
-    p += 4;
-    uint16_t cmd_len = *(uint16_t*)p;
-    p += 2;
-    if (p + cmd_len + 1 > pend) {
-      ok = false;
-      return msg;
+    const char* p = payload.data();
+    const char* pend = p + payload.size();
+    msg.seq = load_le<uint32_t>(p);
+    const uint16_t cmd_len = load_le<uint16_t>(p + 4);
+    p += 6;
+    if (cmd_len == CmdIdMark) {
+      if (pend - p < 4 + 1) {
+        return msg;
+      }
+      msg.with_cmd_id = true;
+      msg.cmd_id = load_le<uint32_t>(p);
+      p += 4;
+    } else {
+      if (pend - p < cmd_len + 1) {
+        return msg;
+      }
+      msg.cmd_view = detail::string_view(p, cmd_len);
+      p += cmd_len;
     }
-    msg.cmd.assign(p, cmd_len);
-    p += cmd_len;
-    msg.type = *(msg_wrapper::msg_type*)(p);
+    msg.type = static_cast<msg_wrapper::msg_type>(*p);
     p += 1;
-    msg.data.assign(p, pend - p);
+    msg.data_view = detail::string_view(p, pend - p);
     ok = true;
     return msg;
   }
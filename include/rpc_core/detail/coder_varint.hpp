@@ -1,5 +1,7 @@
 #pragma once
 
+#include "cmd_id.hpp"
+#include "log.h"
 #include "msg_wrapper.hpp"
 #include "varint.hpp"
 
@@ -8,41 +10,82 @@ namespace detail {
 
 class coder {
  public:
+  /**
+   * segments of a serialized msg: header(seq, cmd_len[, cmd_id]), cmd, type, payload
+   * cmd, type and payload point into msg, so msg should outlive it
+   */
+  struct iov_buffer {
+    static const uint8_t Count = 4;
+    char header[(sizeof(uint32_t) + 1) * 3];  // seq, cmd_len or CmdIdMark, cmd_id
+    detail::string_view segments[Count];
+  };
+
+  /**
+   * @return false if cmd is too long, its length would be read as CmdIdMark
+   */
+  static bool serialize(const msg_wrapper& msg, iov_buffer& iov) {
+    if (!msg.with_cmd_id && msg.cmd.length() >= CmdIdMark) {
+      RPC_CORE_LOGE("cmd too long: %zu", msg.cmd.length());
+      return false;
+    }
+    auto header = (uint8_t*)iov.header;
+    auto p = varint_encode(msg.seq, header);
+    if (msg.with_cmd_id) {
+      p = varint_encode(CmdIdMark, p);
+      p = varint_encode(msg.cmd_id, p);
+      iov.segments[1] = detail::string_view();
+    } else {
+      p = varint_encode(msg.cmd.length(), p);
+      iov.segments[1] = detail::string_view(msg.cmd);
+    }
+    iov.segments[0] = detail::string_view(iov.header, p - header);
+    iov.segments[2] = detail::string_view((char*)&msg.type, sizeof(msg.type));
+    iov.segments[3] = msg.request_payload ? detail::string_view(*msg.request_payload) : detail::string_view(msg.data);
+    return true;
+  }
+
   static std::string serialize(const msg_wrapper& msg) {
+    iov_buffer iov;
     std::string payload;
-    std::string v_seq = to_varint(msg.seq);
-    std::string v_cmd_len = to_varint(msg.cmd.length());
-    payload.reserve(v_seq.size() + v_cmd_len.size() + sizeof(msg.type) + msg.cmd.size() + msg.data.size());
-    payload.append(v_seq);
-    payload.append(v_cmd_len);
-    payload.append(msg.cmd);
-    payload.append((char*)&msg.type, sizeof(msg.type));
-    if (msg.request_payload) {
-      payload.append(*msg.request_payload);
-    } else {
-      payload.append(msg.data);
+    if (!serialize(msg, iov)) {
+      return payload;
+    }
+    payload.reserve(iov.segments[0].size() + iov.segments[1].size() + sizeof(msg.type) + iov.segments[3].size());
+    for (const auto& seg : iov.segments) {
+      payload.append(seg.data(), seg.size());
     }
     return payload;
   }
 
-  static msg_wrapper deserialize(const std::string& payload, bool& ok) {
+  /**
+   * nothing is copied, cmd_view and data_view point into payload, so payload should outlive the returned msg
+   */
+  static msg_wrapper deserialize(const detail::string_view& payload, bool& ok) {
     msg_wrapper msg;
-    char* p = (char*)payload.data();
-    const char* pend = payload.data() + payload.size();
-    uint8_t bytes;
-    msg.seq = from_varint(p, &bytes);
-    p += bytes;
-    uint16_t cmd_len = from_varint(p, &bytes);
-    p += bytes;
-    if (p + cmd_len + sizeof(msg.type) > pend) {
-      ok = false;
+    ok = false;
+    auto p = (const uint8_t*)payload.data();
+    auto pend = p + payload.size();
+    uint64_t value;
+    if ((p = varint_decode(p, pend, value)) == nullptr) return msg;
+    msg.seq = (seq_type)value;
+    if ((p = varint_decode(p, pend, value)) == nullptr) return msg;
+    // checked before narrowing, or a huge length wraps the bounds check below
+    if (value > CmdIdMark) return msg;
+    auto cmd_len = (uint16_t)value;
+    if (cmd_len == CmdIdMark) {
+      if ((p = varint_decode(p, pend, value)) == nullptr) return msg;
+      msg.with_cmd_id = true;
+      msg.cmd_id = (cmd_id_type)value;
+      cmd_len = 0;
+    }
+    if ((size_t)(pend - p) < (size_t)cmd_len + sizeof(msg.type)) {
       return msg;
     }
-    msg.cmd.assign(p, cmd_len);
+    msg.cmd_view = detail::string_view((const char*)p, cmd_len);
     p += cmd_len;
-    msg.type = *(msg_wrapper::msg_type*)(p);
+    msg.type = static_cast<msg_wrapper::msg_type>(*p);
     p += sizeof(msg.type);
-    msg.data.assign(p, pend - p);
+    msg.data_view = detail::string_view((const char*)p, pend - p);
     ok = true;
     return msg;
   }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "lz.hpp"
+#include "string_view.hpp"
+
+namespace rpc_core {
+namespace detail {
+
+/**
+ * Payload compression, compressed payload: [id(1)][raw size(4 bytes LE)][compressed data]
+ * id is used by the receiver to choose decompressor, 0 is invalid, 1 is the bundled lz.
+ */
+struct compressor {
+  uint8_t id = 0;
+  /**
+   * @return false if data can not be compressed smaller
+   */
+  std::function<bool(const string_view& in, std::string& out)> compress;
+  /**
+   * @param raw_size size before compress
+   */
+  std::function<bool(const string_view& in, size_t raw_size, std::string& out)> decompress;
+};
+
+inline compressor lz_compressor() {
+  compressor c;
+  c.id = 1;
+  c.compress = [](const string_view& in, std::string& out) {
+    return lz::compress(in.data(), in.size(), out);
+  };
+  c.decompress = [](const string_view& in, size_t raw_size, std::string& out) {
+    return lz::decompress(in.data(), in.size(), raw_size, out);
+  };
+  return c;
+}
+
+}  // namespace detail
+}  // namespace rpc_core
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <functional>
 #include <string>
 
 // #define RPC_CORE_LOG_SHOW_VERBOSE
+#include "endian.hpp"
 #include "log.h"
 #include "noncopyable.hpp"
+#include "string_view.hpp"
+#include "type_traits.hpp"
 
 namespace rpc_core {
 namespace detail {
@@ -20,7 +24,9 @@ class data_packer : detail::noncopyable {
     if (size > max_body_size_) {
       return false;
     }
-    auto ret = cb(&size, 4);
+    char header[4];
+    store_le<uint32_t>(header, (uint32_t)size);
+    auto ret = cb(header, 4);
     if (!ret) return false;
     ret = cb(data, size);
     if (!ret) return false;
@@ -34,8 +40,9 @@ class data_packer : detail::noncopyable {
       RPC_CORE_LOGW("size > max_body_size: %zu > %u", size, max_body_size_);
       return payload;
     }
-    payload.insert(0, (char *)&size, 4);
-    payload.insert(payload.size(), (char *)data, size);
+    payload.resize(4);
+    store_le<uint32_t>(&payload[0], (uint32_t)size);
+    payload.append((char *)data, size);
     return payload;
   }
 
@@ -43,39 +50,91 @@ class data_packer : detail::noncopyable {
     return pack(data.data(), data.size());
   }
 
- public:
-  bool feed(const void *data, size_t size) {  // NOLINT(misc-no-recursion)
-    if (body_size_ != 0) {
-      feed_body(data, size);
-      return true;
+  /**
+   * Pack segments as one package, cb will get the segments with header, like writev.
+   * The segments passed to cb are only valid during the call.
+   */
+  bool pack(const detail::string_view *segments, size_t count,
+            const std::function<void(const detail::string_view *segments, size_t count)> &cb) const {
+    if (count > MaxSegments) {
+      RPC_CORE_LOGE("too many segments: %zu", count);
+      return false;
     }
-
-    /// wait header(4 bytes)
-    if (header_len_now_ + size < 4) {
-      buffer_.insert(buffer_.size(), (char *)data, size);
-      header_len_now_ += (uint32_t)size;
-      return true;
+    uint32_t size = 0;
+    if (!body_size_of(segments, count, size)) {
+      return false;
+    }
+    char header[4];
+    store_le<uint32_t>(header, size);
+    detail::string_view iov[MaxSegments + 1];
+    iov[0] = detail::string_view(header, 4);
+    for (size_t i = 0; i < count; ++i) {
+      iov[i + 1] = segments[i];
     }
+    cb(iov, count + 1);
+    return true;
+  }
 
-    /// herder data ready, start read body
-    // 1. read header, aka: body size
-    uint8_t header_len = 4 - header_len_now_;
-    size_t body_len = size - header_len;
-    for (int i = 0; i < header_len; ++i) {
-      buffer_.push_back(((char *)data)[i]);
+  std::string pack(const detail::string_view *segments, size_t count) const {
+    std::string payload;
+    uint32_t size = 0;
+    if (!body_size_of(segments, count, size)) {
+      return payload;
     }
-    body_size_ = *(uint32_t *)(buffer_.data());
-    buffer_.clear();
-    RPC_CORE_LOGV("feed: wait body_size: %u", body_size_);
-    if (body_size_ > max_body_size_) {
-      RPC_CORE_LOGW("body_size > max_body_size: %u > %u", body_size_, max_body_size_);
-      reset();
-      return false;
+    payload.reserve(4 + size);
+    payload.resize(4);
+    store_le<uint32_t>(&payload[0], size);
+    for (size_t i = 0; i < count; ++i) {
+      payload.append(segments[i].data(), segments[i].size());
     }
+    return payload;
+  }
 
-    // 2. feed body
-    if (body_len != 0) {
-      feed_body((char *)data + header_len, body_len);
+ public:
+  /**
+   * Feed received bytes, complete packages will be delivered by on_data_view or on_data.
+   * If a complete package is already in `data`, it is delivered without copy.
+   */
+  bool feed(const void *data, size_t size) {
+    auto p = (const char *)data;
+    while (size != 0) {
+      /// wait header(4 bytes)
+      if (header_len_now_ < 4) {
+        auto header_need = (uint32_t)detail::min<size_t>(4 - header_len_now_, size);
+        memcpy(header_ + header_len_now_, p, header_need);
+        header_len_now_ += header_need;
+        p += header_need;
+        size -= header_need;
+        if (header_len_now_ < 4) {
+          break;
+        }
+        body_size_ = load_le<uint32_t>(header_);
+        RPC_CORE_LOGV("feed: wait body_size: %u", body_size_);
+        if (body_size_ > max_body_size_) {
+          RPC_CORE_LOGW("body_size > max_body_size: %u > %u", body_size_, max_body_size_);
+          reset();
+          return false;
+        }
+      }
+
+      /// header data ready, read body
+      if (buffer_.empty() && size >= body_size_) {
+        // whole body is in data, zero-copy
+        deliver(p, body_size_);
+        p += body_size_;
+        size -= body_size_;
+      } else {
+        size_t body_need = detail::min<size_t>(body_size_ - buffer_.size(), size);
+        buffer_.append(p, body_need);
+        p += body_need;
+        size -= body_need;
+        if (buffer_.size() < body_size_) {
+          break;
+        }
+        deliver_buffer();
+      }
+      header_len_now_ = 0;
+      body_size_ = 0;
     }
     return true;
   }
@@ -88,30 +147,55 @@ class data_packer : detail::noncopyable {
   }
 
  private:
-  void feed_body(const void *data, size_t size) {  // NOLINT(misc-no-recursion)
-    if (buffer_.size() + size < body_size_) {
-      buffer_.insert(buffer_.size(), (char *)data, size);
-    } else {
-      size_t body_need = body_size_ - buffer_.size();
-      size_t body_left = size - body_need;
-      buffer_.insert(buffer_.size(), (char *)data, body_need);
-      if (on_data) on_data(std::move(buffer_));
-
-      reset();
-
-      if (body_left != 0) {
-        feed((char *)data + body_need, body_left);
-      }
+  bool body_size_of(const detail::string_view *segments, size_t count, uint32_t &body_size) const {
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+      size += segments[i].size();
+    }
+    if (size > max_body_size_) {
+      RPC_CORE_LOGW("size > max_body_size: %zu > %u", size, max_body_size_);
+      return false;
+    }
+    body_size = (uint32_t)size;
+    return true;
+  }
+
+  void deliver(const char *data, size_t size) {
+    if (on_data_view) {
+      on_data_view(detail::string_view(data, size));
+    } else if (on_data) {
+      on_data(std::string(data, size));
     }
   }
 
+  void deliver_buffer() {
+    if (on_data_view) {
+      on_data_view(detail::string_view(buffer_));
+    } else if (on_data) {
+      on_data(std::move(buffer_));
+    }
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+  }
+
  public:
   std::function<void(std::string)> on_data;
 
+  /**
+   * Zero-copy alternative of on_data, has higher priority.
+   * The view points into the data passed to feed() or the inner buffer,
+   * it is only valid during the call, copy it if the package needs to be kept.
+   */
+  std::function<void(const detail::string_view &)> on_data_view;
+
+ public:
+  static const size_t MaxSegments = 8;
+
  private:
   uint32_t max_body_size_;
   std::string buffer_;
 
+  char header_[4]{};
   uint32_t header_len_now_ = 0;
   uint32_t body_size_ = 0;
 };
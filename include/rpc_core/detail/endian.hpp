@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+namespace rpc_core {
+namespace detail {
+
+/**
+ * Convert between host order and little endian, wire format is little endian.
+ */
+template <typename T>
+inline T to_le(T v) {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  T r = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    r = (T)((r << 8) | (v & 0xff));
+    v = (T)(v >> 8);
+  }
+  return r;
+#else
+  return v;
+#endif
+}
+
+/**
+ * Unaligned little endian load/store of unsigned integer, memcpy compiles to a single load/store.
+ */
+template <typename T>
+inline T load_le(const void* p) {
+  T v;
+  std::memcpy(&v, p, sizeof(T));
+  return to_le(v);
+}
+
+template <typename T>
+inline void store_le(void* p, T v) {
+  v = to_le(v);
+  std::memcpy(p, &v, sizeof(T));
+}
+
+}  // namespace detail
+}  // namespace rpc_core
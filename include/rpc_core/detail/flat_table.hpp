@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "noncopyable.hpp"
+
+namespace rpc_core {
+namespace detail {
+
+/**
+ * Open addressing hash table with linear probing, the caller provides the 32 bits hash of key.
+ * Erase uses backward shift instead of tombstone, so lookup never walks over deleted slots.
+ * Notice: insert may move values, pointers returned by find() are invalid after insert.
+ */
+template <typename T>
+class flat_table : noncopyable {
+  struct slot {
+    uint32_t hash = 0;
+    bool used = false;
+    T value{};
+  };
+
+ public:
+  explicit flat_table(size_t capacity = 16) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    slots_.resize(size);
+  }
+
+  template <typename Pred>
+  T* find(uint32_t hash, Pred pred) {
+    size_t index = find_index(hash, pred);
+    return index == npos ? nullptr : &slots_[index].value;
+  }
+
+  T* insert(uint32_t hash, T value) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+      grow();
+    }
+    auto& s = slots_[empty_index(hash)];
+    s.hash = hash;
+    s.used = true;
+    s.value = std::move(value);
+    ++size_;
+    return &s.value;
+  }
+
+  template <typename Pred>
+  bool erase(uint32_t hash, Pred pred) {
+    size_t index = find_index(hash, pred);
+    if (index == npos) return false;
+    erase_at(index);
+    return true;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  template <typename F>
+  void for_each(F f) {
+    for (auto& s : slots_) {
+      if (s.used) f(s.value);
+    }
+  }
+
+ private:
+  static const size_t npos = (size_t)-1;
+
+  template <typename Pred>
+  size_t find_index(uint32_t hash, Pred& pred) {
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      auto& s = slots_[i];
+      if (!s.used) return npos;
+      if (s.hash == hash && pred(s.value)) return i;
+    }
+  }
+
+  size_t empty_index(uint32_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i].used) {
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+  void erase_at(size_t i) {
+    const size_t mask = slots_.size() - 1;
+    slots_[i] = slot();
+    for (size_t j = (i + 1) & mask; slots_[j].used; j = (j + 1) & mask) {
+      size_t k = slots_[j].hash & mask;
+      // keep slot j if its ideal index k is cyclically in (i, j]
+      bool keep = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+      if (keep) continue;
+      slots_[i] = std::move(slots_[j]);
+      slots_[j] = slot();
+      i = j;
+    }
+    --size_;
+  }
+
+  void grow() {
+    std::vector<slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    for (auto& s : old) {
+      if (!s.used) continue;
+      auto& n = slots_[empty_index(s.hash)];
+      n = std::move(s);
+    }
+  }
+
+ private:
+  std::vector<slot> slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace detail
+}  // namespace rpc_core
@@ -0,0 +1,45 @@
+#pragma once
+
+#ifdef RPC_CORE_FEATURE_THREAD_SAFE
+#include <atomic>
+#include <mutex>
+#endif
+
+#include "noncopyable.hpp"
+
+namespace rpc_core {
+namespace detail {
+
+#ifdef RPC_CORE_FEATURE_THREAD_SAFE
+using mutex = std::mutex;
+
+template <typename T>
+using atomic = std::atomic<T>;
+#else
+/**
+ * no-op when RPC_CORE_FEATURE_THREAD_SAFE is off, keep single thread mode zero overhead
+ */
+struct mutex : noncopyable {
+  void lock() {}
+  void unlock() {}
+};
+
+template <typename T>
+using atomic = T;
+#endif
+
+class lock_guard : noncopyable {
+ public:
+  explicit lock_guard(mutex& m) : m_(m) {
+    m_.lock();
+  }
+  ~lock_guard() {
+    m_.unlock();
+  }
+
+ private:
+  mutex& m_;
+};
+
+}  // namespace detail
+}  // namespace rpc_core
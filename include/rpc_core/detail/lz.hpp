@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace rpc_core {
+namespace detail {
+
+/**
+ * Small LZ77 codec, block format like LZ4:
+ * sequence: token(literal_len:4 | match_len-4:4) [literal_len ext] literals offset(2 bytes LE) [match_len ext]
+ * ext: bytes of 255 and a byte < 255 are added to 15. The last sequence has literals only.
+ */
+namespace lz {
+
+static const uint32_t HashLog = 12;
+static const size_t MinMatch = 4;
+static const size_t MaxOffset = 65535;
+
+inline uint32_t read32(const uint8_t* p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+inline void write_len(std::string& out, size_t len) {
+  while (len >= 255) {
+    out.push_back((char)255);
+    len -= 255;
+  }
+  out.push_back((char)len);
+}
+
+inline void write_sequence(std::string& out, const uint8_t* literals, size_t literal_len, size_t offset, size_t match_len) {
+  const size_t m = match_len ? match_len - MinMatch : 0;
+  uint8_t token = (uint8_t)(((literal_len < 15 ? literal_len : 15) << 4) | (m < 15 ? m : 15));
+  out.push_back((char)token);
+  if (literal_len >= 15) write_len(out, literal_len - 15);
+  out.append((const char*)literals, literal_len);
+  if (match_len == 0) return;
+  out.push_back((char)(offset & 0xff));
+  out.push_back((char)(offset >> 8));
+  if (m >= 15) write_len(out, m - 15);
+}
+
+/**
+ * @return false if output is not smaller than input
+ */
+inline bool compress(const void* data, size_t size, std::string& out) {
+  out.clear();
+  if (size < MinMatch * 2) return false;
+  out.reserve(size);
+  const auto* in = (const uint8_t*)data;
+  // 16 KB, too large for the stack of embedded targets
+  std::vector<uint32_t> table(1 << HashLog);
+  size_t anchor = 0;
+  size_t ip = 0;
+  while (ip + MinMatch <= size) {
+    const uint32_t seq = read32(in + ip);
+    const uint32_t h = (seq * 2654435761u) >> (32 - HashLog);
+    const size_t ref = table[h];
+    table[h] = (uint32_t)ip;
+    if (ref < ip && ip - ref <= MaxOffset && read32(in + ref) == seq) {
+      size_t len = MinMatch;
+      while (ip + len < size && in[ref + len] == in[ip + len]) ++len;
+      write_sequence(out, in + anchor, ip - anchor, ip - ref, len);
+      ip += len;
+      anchor = ip;
+      if (out.size() >= size) return false;
+    } else {
+      ++ip;
+    }
+  }
+  write_sequence(out, in + anchor, size - anchor, 0, 0);
+  return out.size() < size;
+}
+
+inline bool read_len(const uint8_t*& ip, const uint8_t* end, size_t& len) {
+  uint8_t b;
+  do {
+    if (ip >= end) return false;
+    b = *ip++;
+    len += b;
+  } while (b == 255);
+  return true;
+}
+
+/**
+ * @param raw_size size before compress, from the wire: caller should limit it, out is resized to it
+ */
+inline bool decompress(const void* data, size_t size, size_t raw_size, std::string& out) {
+  // each input byte can not expand to more than 255 bytes
+  if (raw_size / 255 > size) return false;
+  out.resize(raw_size);
+  auto* op = (uint8_t*)&out[0];
+  const uint8_t* oend = op + raw_size;
+  const auto* ip = (const uint8_t*)data;
+  const uint8_t* end = ip + size;
+  while (ip < end) {
+    const uint8_t token = *ip++;
+    size_t literal_len = token >> 4;
+    if (literal_len == 15 && !read_len(ip, end, literal_len)) return false;
+    if ((size_t)(end - ip) < literal_len || (size_t)(oend - op) < literal_len) return false;
+    std::memcpy(op, ip, literal_len);
+    ip += literal_len;
+    op += literal_len;
+    if (ip == end) break;
+
+    if (end - ip < 2) return false;
+    const size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t match_len = token & 15;
+    if (match_len == 15 && !read_len(ip, end, match_len)) return false;
+    match_len += MinMatch;
+    if (offset == 0 || offset > (size_t)(op - (const uint8_t*)out.data()) || (size_t)(oend - op) < match_len) return false;
+    const uint8_t* match = op - offset;
+    // overlapped copy
+    for (size_t i = 0; i < match_len; ++i) {
+      op[i] = match[i];
+    }
+    op += match_len;
+  }
+  return op == oend;
+}
+
+}  // namespace lz
+
+}  // namespace detail
+}  // namespace rpc_core
@@ -1,13 +1,22 @@
 #pragma once
 
-#include <map>
+#include <deque>
 #include <memory>
+#include <string>
 #include <utility>
 
+#include "../arena.hpp"
 #include "../connection.hpp"
+#include "cmd_id.hpp"
 #include "coder.hpp"
+#include "compressor.hpp"
+#include "endian.hpp"
+#include "flat_table.hpp"
+#include "lock.hpp"
 #include "log.h"
 #include "noncopyable.hpp"
+#include "rsp_handler.hpp"
+#include "timing_wheel.hpp"
 
 namespace rpc_core {
 namespace detail {
@@ -15,16 +24,18 @@ namespace detail {
 class msg_dispatcher : public std::enable_shared_from_this<msg_dispatcher>, noncopyable {
  public:
   using cmd_handle = std::function<std::pair<bool, msg_wrapper>(msg_wrapper)>;
-  using rsp_handle = std::function<bool(msg_wrapper)>;
+  using rsp_handle = std::weak_ptr<rsp_handler>;
 
   using timeout_cb = std::function<void()>;
   using timer_impl = std::function<void(uint32_t ms, timeout_cb)>;
 
  public:
-  explicit msg_dispatcher(std::shared_ptr<connection> conn) : conn_(std::move(conn)) {}
+  explicit msg_dispatcher(std::shared_ptr<connection> conn) : conn_(std::move(conn)) {
+    decompressors_.push_back(lz_compressor());
+  }
 
   void init() {
-    conn_->on_recv_package = ([self = std::weak_ptr<msg_dispatcher>(shared_from_this())](const std::string& payload) {
+    auto on_recv = [self = std::weak_ptr<msg_dispatcher>(shared_from_this())](const detail::string_view& payload) {
       auto self_lock = self.lock();
       if (!self_lock) {
         RPC_CORE_LOGD("msg_dispatcher expired");
@@ -37,11 +48,97 @@ class msg_dispatcher : public std::enable_shared_from_this<msg_dispatcher>, nonc
       } else {
         RPC_CORE_LOGE("payload deserialize error");
       }
-    });
+    };
+    conn_->on_recv_package = on_recv;
+    conn_->on_recv_package_view = std::move(on_recv);
+    conn_->on_recv_begin = [self = std::weak_ptr<msg_dispatcher>(shared_from_this())] {
+      auto self_lock = self.lock();
+      if (self_lock) {
+        ++self_lock->recv_depth_;
+      }
+    };
+    conn_->on_recv_end = [self = std::weak_ptr<msg_dispatcher>(shared_from_this())] {
+      auto self_lock = self.lock();
+      if (self_lock && self_lock->recv_depth_ > 0 && --self_lock->recv_depth_ == 0) {
+        self_lock->flush_batch();
+      }
+    };
+  }
+
+  /**
+   * Responses produced while handling one read are sent as one batch package.
+   * Only takes effect when the connection calls on_recv_begin/on_recv_end, and the peer should support batch.
+   */
+  inline void set_batch_response(bool enable, size_t max_bytes) {
+    batch_response_ = enable;
+    batch_max_bytes_ = max_bytes;
+  }
+
+  /**
+   * Compress payload not smaller than threshold, the compressor is also used for decompress.
+   * Decompression is enabled with DefaultMaxRawSize if it was not enabled.
+   */
+  void set_compressor(compressor c, size_t threshold) {
+    bool registered = false;
+    for (auto& d : decompressors_) {
+      if (d.id == c.id) {
+        d = c;
+        registered = true;
+      }
+    }
+    if (!registered) {
+      decompressors_.push_back(c);
+    }
+    compressor_ = std::move(c);
+    compress_threshold_ = threshold;
+    if (max_raw_size_ == 0) {
+      max_raw_size_ = DefaultMaxRawSize;
+    }
+  }
+
+  /**
+   * Accept compressed packages by the bundled lz and registered compressors.
+   * @param max_raw_size larger decompressed size is rejected before allocation, 0 means disable
+   */
+  inline void set_decompression(size_t max_raw_size) {
+    max_raw_size_ = max_raw_size;
+  }
+
+  static const size_t DefaultMaxRawSize = 1024 * 1024;
+
+  inline void disable_compressor() {
+    compressor_ = compressor();
+  }
+
+  /**
+   * Messages are dispatched in arena scope, the arena is reset after the outermost dispatch returns.
+   * @param block_size 0 means disable
+   */
+  void set_arena(size_t block_size) {
+    if (arena_ && arena_->in_scope()) {
+      RPC_CORE_LOGE("set_arena during dispatch is ignored");
+      return;
+    }
+    arena_.reset(block_size ? new arena(block_size) : nullptr);
   }
 
  private:
   void dispatch(msg_wrapper msg) {
+    arena::scope arena_scope(arena_.get());
+    // keep decompressed payload during dispatch
+    std::string raw;
+    if (msg.type & msg_wrapper::compressed) {
+      if (!decompress(msg.data_view, raw)) {
+        RPC_CORE_LOGE("decompress error: %s", msg.dump().c_str());
+        return;
+      }
+      msg.data_view = raw;
+      msg.type = static_cast<msg_wrapper::msg_type>(msg.type & ~msg_wrapper::compressed);
+    }
+    if (msg.type & msg_wrapper::batch) {
+      dispatch_batch(msg.data_view);
+      return;
+    }
     switch (msg.type & (msg_wrapper::command | msg_wrapper::response)) {
       case msg_wrapper::command: {
         // ping
@@ -49,28 +146,29 @@ class msg_dispatcher : public std::enable_shared_from_this<msg_dispatcher>, nonc
         if (is_ping) {
           RPC_CORE_LOGD("<= seq:%u type:ping", msg.seq);
           msg.type = static_cast<msg_wrapper::msg_type>(msg_wrapper::response | msg_wrapper::pong);
+          msg.data.assign(msg.data_view.data(), msg.data_view.size());
           RPC_CORE_LOGD("=> seq:%u type:pong", msg.seq);
-          conn_->send_package_impl(coder::serialize(msg));
+          send_rsp(msg);
           return;
         }
 
         // command
-        RPC_CORE_LOGD("<= seq:%u cmd:%s", msg.seq, msg.cmd.c_str());
-        const auto& cmd = msg.cmd;
-        auto it = cmd_handle_map_.find(cmd);
-        if (it == cmd_handle_map_.cend()) {
-          RPC_CORE_LOGD("not subscribe cmd for: %s", cmd.c_str());
+        RPC_CORE_LOGD("<= %s", msg.dump().c_str());
+        auto entry = find_cmd(msg);
+        if (entry == nullptr) {
+          RPC_CORE_LOGD("not subscribe cmd for: %s", msg.dump().c_str());
           const bool need_rsp = msg.type & msg_wrapper::need_rsp;
           if (need_rsp) {
             RPC_CORE_LOGD("=> seq:%u type:rsp", msg.seq);
             msg_wrapper rsp;
             rsp.seq = msg.seq;
             rsp.type = static_cast<msg_wrapper::msg_type>(msg_wrapper::msg_type::response | msg_wrapper::msg_type::no_such_cmd);
-            conn_->send_package_impl(coder::serialize(rsp));
+            send_rsp(rsp);
           }
           return;
         }
-        const auto& fn = it->second;
+        // copy: handle may unsubscribe or subscribe cmd which moves entries
+        auto fn = entry->handle;
         const bool need_rsp = msg.type & msg_wrapper::need_rsp;
         auto resp = fn(std::move(msg));
         if (need_rsp) {
@@ -81,7 +179,7 @@ class msg_dispatcher : public std::enable_shared_from_this<msg_dispatcher>, nonc
             } break;
             case msg_wrapper::response_state::response_sync: {
               RPC_CORE_LOGD("=> seq:%u type:rsp", resp.second.seq);
-              conn_->send_package_impl(coder::serialize(resp.second));
+              send_rsp(resp.second);
             } break;
             case msg_wrapper::response_state::response_async: {
               RPC_CORE_LOGD("=> seq:%u type:rsp_async", resp.second.seq);
@@ -89,18 +187,25 @@ class msg_dispatcher : public std::enable_shared_from_this<msg_dispatcher>, nonc
                 resp.second.data = resp.second.async_helper->get_data();
                 resp.second.async_helper->is_ready = nullptr;
                 resp.second.async_helper->get_data = nullptr;
-                conn_->send_package_impl(coder::serialize(resp.second));
+                send_rsp(resp.second);
               } else {
-                auto helper = resp.second.async_helper.get();
-                helper->send_async_response = [c = std::weak_ptr<connection>(conn_), mw = std::move(resp.second)](std::string data) mutable {
+                // is_ready holds request_response, whose rsp holds the helper, release them to break the cycle
+                auto helper = std::move(resp.second.async_helper);
+                helper->is_ready = nullptr;
+                helper->get_data = nullptr;
+                helper->send_async_response = [self = std::weak_ptr<msg_dispatcher>(shared_from_this()),
+                                               mw = std::move(resp.second)](std::string data) mutable {
                   mw.data = std::move(data);
-                  auto conn = c.lock();
-                  if (conn) {
-                    conn->send_package_impl(coder::serialize(mw));
+                  auto self_lock = self.lock();
+                  if (self_lock) {
+                    self_lock->send_msg(mw);
                   }
                 };
               }
             } break;
+            case msg_wrapper::response_state::response_stream: {
+              RPC_CORE_LOGD("=> seq:%u type:rsp_stream", resp.second.seq);
+            } break;
           }
         }
       } break;
@@ -108,22 +213,23 @@ class msg_dispatcher : public std::enable_shared_from_this<msg_dispatcher>, nonc
       case msg_wrapper::response: {
         // pong or response
         RPC_CORE_LOGD("<= seq:%u type:%s", msg.seq, (msg.type & detail::msg_wrapper::msg_type::pong) ? "pong" : "rsp");
-        auto it = rsp_handle_map_.find(msg.seq);
-        if (it == rsp_handle_map_.cend()) {
+        // take it out first: handler may send new requests and grow the table
+        // response with need_rsp is an item of stream response, keep waiting for more
+        bool found;
+        auto handler = (msg.type & msg_wrapper::need_rsp) ? peek_rsp_handler(msg.seq, found) : take_rsp_handler(msg.seq, found);
+        if (!found) {
           RPC_CORE_LOGD("no rsp for seq:%u", msg.seq);
           break;
         }
-        const auto& cb = it->second;
-        if (!cb) {
-          RPC_CORE_LOGE("rsp can not be null");
-          return;
+        if (!handler) {
+          RPC_CORE_LOGD("request expired for seq:%u", msg.seq);
+          break;
         }
-        if (cb(std::move(msg))) {
+        if (handler->on_rsp(std::move(msg))) {
           RPC_CORE_LOGV("rsp_handle_map_.size=%zu", rsp_handle_map_.size());
         } else {
           RPC_CORE_LOGE("may deserialize error");
         }
-        rsp_handle_map_.erase(it);
       } break;
 
       default:
@@ -131,58 +237,382 @@ class msg_dispatcher : public std::enable_shared_from_this<msg_dispatcher>, nonc
     }
   }
 
+  void dispatch_batch(const string_view& payload) {
+    const char* p = payload.data();
+    const char* end = p + payload.size();
+    while (end - p >= 4) {
+      const uint32_t size = load_le<uint32_t>(p);
+      p += 4;
+      if ((size_t)(end - p) < size) break;
+      bool success;
+      auto msg = coder::deserialize(string_view(p, size), success);
+      p += size;
+      if (success && !(msg.type & msg_wrapper::batch)) {
+        dispatch(std::move(msg));
+      } else {
+        RPC_CORE_LOGE("batch record error");
+      }
+    }
+    if (p != end) {
+      RPC_CORE_LOGE("batch payload error");
+    }
+  }
+
+  void send_rsp(const msg_wrapper& msg) {
+    if (!batch_response_ || recv_depth_ == 0) {
+      send_msg(msg);
+      return;
+    }
+    coder::iov_buffer iov;
+    uint8_t type;
+    std::string holder;
+    if (!encode(msg, iov, type, holder)) return;
+    uint32_t size = 0;
+    for (const auto& segment : iov.segments) {
+      size += (uint32_t)segment.size();
+    }
+    char size_le[4];
+    store_le<uint32_t>(size_le, size);
+    batch_buffer_.append(size_le, 4);
+    for (const auto& segment : iov.segments) {
+      batch_buffer_.append(segment.data(), segment.size());
+    }
+    ++batch_count_;
+    if (batch_buffer_.size() >= batch_max_bytes_) {
+      flush_batch();
+    }
+  }
+
+  void flush_batch() {
+    if (batch_count_ == 0) return;
+    // sending may cause new responses on loopback/synchronous transport
+    std::string buffer;
+    buffer.swap(batch_buffer_);
+    const uint32_t count = batch_count_;
+    batch_count_ = 0;
+    if (count == 1) {
+      detail::string_view package(buffer.data() + 4, buffer.size() - 4);
+      send_segments(&package, 1);
+    } else {
+      msg_wrapper msg;
+      msg.seq = 0;
+      msg.type = msg_wrapper::batch;
+      msg.request_payload = &buffer;
+      RPC_CORE_LOGD("=> batch rsp count:%u", count);
+      send_msg(msg);
+    }
+    if (batch_buffer_.empty()) {
+      buffer.clear();
+      buffer.swap(batch_buffer_);
+    }
+  }
+
  public:
+  void send_msg(const msg_wrapper& msg) {
+    coder::iov_buffer iov;
+    uint8_t type;
+    std::string holder;
+    if (!encode(msg, iov, type, holder)) return;
+    send_segments(iov.segments, coder::iov_buffer::Count);
+  }
+
   inline void subscribe_cmd(const cmd_type& cmd, cmd_handle handle) {
-    RPC_CORE_LOGD("subscribe cmd:%s", cmd.c_str());
-    cmd_handle_map_[cmd] = std::move(handle);
+    auto cmd_id = make_cmd_id(cmd);
+    RPC_CORE_LOGD("subscribe cmd:%s id:%08x", cmd.c_str(), cmd_id);
+    auto entry = cmd_handle_map_.find(cmd_id, cmd_equal(cmd));
+    if (entry != nullptr) {
+      entry->handle = std::move(handle);
+      return;
+    }
+    auto exist = cmd_handle_map_.find(cmd_id, any_entry());
+    if (exist != nullptr) {
+      RPC_CORE_LOGE("cmd id conflict: %s and %s, requests of them by cmd id get no_such_cmd", exist->cmd.c_str(), cmd.c_str());
+    }
+    cmd_handle_map_.insert(cmd_id, cmd_entry{cmd, std::move(handle)});
   }
 
   void unsubscribe_cmd(const cmd_type& cmd) {
-    auto it = cmd_handle_map_.find(cmd);
-    if (it != cmd_handle_map_.cend()) {
+    if (cmd_handle_map_.erase(make_cmd_id(cmd), cmd_equal(cmd))) {
       RPC_CORE_LOGD("erase cmd:%s", cmd.c_str());
-      cmd_handle_map_.erase(it);
     } else {
       RPC_CORE_LOGD("not subscribe cmd for: %s", cmd.c_str());
     }
   }
 
-  void subscribe_rsp(seq_type seq, rsp_handle handle, timeout_cb timeout_cb, uint32_t timeout_ms) {
+  void subscribe_rsp(seq_type seq, rsp_handle handle, uint32_t timeout_ms) {
     RPC_CORE_LOGD("subscribe_rsp seq:%u", seq);
-    if (handle == nullptr) return;
+
+    if (timing_wheel_ != nullptr) {
+      lock_guard lock(rsp_mutex_);
+      add_rsp_handle(seq, std::move(handle));
+      timing_wheel_->add(seq, timeout_ms);
+      return;
+    }
 
     if (timer_impl_ == nullptr) {
       RPC_CORE_LOGW("no timeout will cause memory leak!");
       return;
     }
 
-    rsp_handle_map_[seq] = std::move(handle);
-    timer_impl_(timeout_ms, [self = std::weak_ptr<msg_dispatcher>(shared_from_this()), seq, timeout_cb = std::move(timeout_cb)] {
+    {
+      lock_guard lock(rsp_mutex_);
+      add_rsp_handle(seq, std::move(handle));
+    }
+    timer_impl_(timeout_ms, [self = std::weak_ptr<msg_dispatcher>(shared_from_this()), seq] {
       auto self_lock = self.lock();
       if (!self_lock) {
         RPC_CORE_LOGD("seq:%u timeout after destroy", seq);
         return;
       }
-      auto it = self_lock->rsp_handle_map_.find(seq);
-      if (it != self_lock->rsp_handle_map_.cend()) {
-        if (timeout_cb) {
-          timeout_cb();
-        }
-        self_lock->rsp_handle_map_.erase(seq);
-        RPC_CORE_LOGV("Timeout seq=%d, rsp_handle_map_.size=%zu", seq, this->rsp_handle_map_.size());
-      }
+      self_lock->on_rsp_timeout(seq);
     });
   }
 
+  /**
+   * stop waiting for the response of seq, late responses of it are dropped
+   */
+  void unsubscribe_rsp(seq_type seq) {
+    lock_guard lock(rsp_mutex_);
+    erase_rsp_handle(seq);
+  }
+
   inline void set_timer_impl(timer_impl timer_impl) {
     timer_impl_ = std::move(timer_impl);
   }
 
+  /**
+   * use built-in timing wheel instead of timer_impl, tick() should be called periodically
+   */
+  void enable_timing_wheel(uint32_t tick_ms, uint32_t slot_count) {
+    timing_wheel_.reset(new timing_wheel(tick_ms, slot_count));
+  }
+
+  void tick(uint32_t now_ms) {
+    if (timing_wheel_ == nullptr) return;
+    auto self = shared_from_this();
+    // local: tick() may be called from more than one thread
+    std::vector<seq_type> expired;
+    {
+      lock_guard lock(rsp_mutex_);
+      timing_wheel_->tick(now_ms, expired);
+    }
+    // timeout callback may retry, so call it without lock
+    for (auto seq : expired) {
+      on_rsp_timeout(seq);
+    }
+  }
+
+  size_t pending_size() {
+    lock_guard lock(rsp_mutex_);
+    return rsp_handle_map_.size();
+  }
+
+ private:
+  struct cmd_entry {
+    cmd_type cmd;
+    cmd_handle handle;
+  };
+
+  /**
+   * cmd entry is keyed by cmd id, lookup by cmd compares the string without copy
+   */
+  struct cmd_equal {
+    explicit cmd_equal(const string_view& cmd) : cmd(cmd) {}
+    bool operator()(const cmd_entry& entry) const {
+      return string_view(entry.cmd) == cmd;
+    }
+    string_view cmd;
+  };
+
+  struct any_entry {
+    template <typename T>
+    bool operator()(const T&) const {
+      return true;
+    }
+  };
+
+  void add_rsp_handle(seq_type seq, rsp_handle handle) {
+    auto exist = rsp_handle_map_.find(seq, any_entry());
+    if (exist != nullptr) {
+      *exist = std::move(handle);
+    } else {
+      rsp_handle_map_.insert(seq, std::move(handle));
+    }
+  }
+
+  std::shared_ptr<rsp_handler> peek_rsp_handler(seq_type seq, bool& found) {
+    lock_guard lock(rsp_mutex_);
+    auto handle = rsp_handle_map_.find(seq, any_entry());
+    found = handle != nullptr;
+    return found ? handle->lock() : nullptr;
+  }
+
+  std::shared_ptr<rsp_handler> take_rsp_handler(seq_type seq, bool& found) {
+    lock_guard lock(rsp_mutex_);
+    auto handle = rsp_handle_map_.find(seq, any_entry());
+    found = handle != nullptr;
+    if (!found) return nullptr;
+    auto handler = handle->lock();
+    erase_rsp_handle(seq);
+    return handler;
+  }
+
+  /**
+   * rsp_mutex_ should be locked
+   */
+  void erase_rsp_handle(seq_type seq) {
+    rsp_handle_map_.erase(seq, any_entry());
+    if (timing_wheel_ != nullptr) {
+      timing_wheel_->remove(seq);
+    }
+  }
+
+  void on_rsp_timeout(seq_type seq) {
+    bool found;
+    auto handler = take_rsp_handler(seq, found);
+    if (handler) {
+      handler->on_timeout();
+    }
+    RPC_CORE_LOGV("Timeout seq=%u, rsp_handle_map_.size=%zu", seq, rsp_handle_map_.size());
+  }
+
+  /**
+   * serialize msg into iov, payload is replaced by compressed one in holder if worth it
+   * type and holder should outlive iov, return false if msg can not be serialized
+   */
+  bool encode(const msg_wrapper& msg, coder::iov_buffer& iov, uint8_t& type, std::string& holder) {
+    if (!coder::serialize(msg, iov)) return false;
+    string_view& payload = iov.segments[3];
+    if (!compressor_.compress || payload.size() < compress_threshold_) return true;
+    std::string data;
+    // not worth it unless saves more than the header
+    if (!compressor_.compress(payload, data) || data.size() + 5 >= payload.size()) return true;
+    const uint32_t raw_size = (uint32_t)payload.size();
+    holder.reserve(data.size() + 5);
+    holder.push_back((char)compressor_.id);
+    char size_le[4];
+    store_le<uint32_t>(size_le, raw_size);
+    holder.append(size_le, 4);
+    holder.append(data);
+    type = (uint8_t)(msg.type | msg_wrapper::compressed);
+    iov.segments[2] = string_view((char*)&type, 1);
+    payload = holder;
+    return true;
+  }
+
+  bool decompress(const string_view& payload, std::string& raw) {
+    if (payload.size() < 5) return false;
+    const uint8_t id = (uint8_t)payload.data()[0];
+    const uint32_t raw_size = load_le<uint32_t>(payload.data() + 1);
+    if (raw_size > max_raw_size_) {
+      RPC_CORE_LOGE("decompressed size %u exceeds limit %zu", raw_size, max_raw_size_);
+      return false;
+    }
+    for (const auto& d : decompressors_) {
+      if (d.id == id && d.decompress) {
+        return d.decompress(string_view(payload.data() + 5, payload.size() - 5), raw_size, raw) && raw.size() == raw_size;
+      }
+    }
+    RPC_CORE_LOGE("no decompressor for id:%u", id);
+    return false;
+  }
+
+  /**
+   * Only one caller runs the send impl at a time, packages sent meanwhile from other threads or re-entrant from a
+   * synchronous transport are queued and sent by it in order, so send_mutex is not held across the send impl.
+   */
+  void send_segments(const string_view* segments, size_t count) {
+    {
+      lock_guard lock(conn_->send_mutex);
+      if (sending_) {
+        send_queue_.push_back(join_segments(segments, count));
+        return;
+      }
+      sending_ = true;
+    }
+    send_impl(segments, count);
+    for (;;) {
+      std::string package;
+      {
+        lock_guard lock(conn_->send_mutex);
+        if (send_queue_.empty()) {
+          sending_ = false;
+          return;
+        }
+        package = std::move(send_queue_.front());
+        send_queue_.pop_front();
+      }
+      string_view segment(package);
+      send_impl(&segment, 1);
+    }
+  }
+
+  void send_impl(const string_view* segments, size_t count) {
+    if (conn_->send_package_iov_impl) {
+      conn_->send_package_iov_impl(segments, count);
+    } else {
+      conn_->send_package_impl(join_segments(segments, count));
+    }
+  }
+
+  static std::string join_segments(const string_view* segments, size_t count) {
+    std::string payload;
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+      size += segments[i].size();
+    }
+    payload.reserve(size);
+    for (size_t i = 0; i < count; ++i) {
+      payload.append(segments[i].data(), segments[i].size());
+    }
+    return payload;
+  }
+
+  cmd_entry* find_cmd(const msg_wrapper& msg) {
+    if (msg.with_cmd_id) {
+      auto entry = cmd_handle_map_.find(msg.cmd_id, any_entry());
+      if (entry == nullptr) return nullptr;
+      // ambiguous if another cmd has the same id
+      auto other = cmd_handle_map_.find(msg.cmd_id, [entry](const cmd_entry& e) {
+        return &e != entry;
+      });
+      if (other != nullptr) {
+        RPC_CORE_LOGE("ambiguous cmd id:%08x for %s and %s", msg.cmd_id, entry->cmd.c_str(), other->cmd.c_str());
+        return nullptr;
+      }
+      return entry;
+    }
+    return cmd_handle_map_.find(make_cmd_id(msg.cmd_view), cmd_equal(msg.cmd_view));
+  }
+
  private:
   std::shared_ptr<connection> conn_;
-  std::map<cmd_type, cmd_handle> cmd_handle_map_;
-  std::map<seq_type, rsp_handle> rsp_handle_map_;
+  flat_table<cmd_entry> cmd_handle_map_;
+  /**
+   * seq is increasing, so hash by seq itself makes in-flight requests occupy adjacent slots
+   */
+  flat_table<rsp_handle> rsp_handle_map_;
   timer_impl timer_impl_;
+  std::unique_ptr<timing_wheel> timing_wheel_;
+  // batch response
+  bool batch_response_ = false;
+  size_t batch_max_bytes_ = 0;
+  uint32_t recv_depth_ = 0;
+  uint32_t batch_count_ = 0;
+  std::string batch_buffer_;
+  // compression
+  compressor compressor_;
+  size_t compress_threshold_ = 0;
+  std::vector<compressor> decompressors_;
+  size_t max_raw_size_ = 0;
+  std::unique_ptr<arena> arena_;
+  // outbound queue, guarded by conn_->send_mutex
+  bool sending_ = false;
+  std::deque<std::string> send_queue_;
+  /**
+   * guard rsp_handle_map_ and timing_wheel_, no-op without RPC_CORE_FEATURE_THREAD_SAFE
+   */
+  mutex rsp_mutex_;
 };
 
 }  // namespace detail
@@ -6,7 +6,7 @@
 #include "../type.hpp"
 #include "copyable.hpp"
 #include "log.h"
-#include "msg_wrapper.hpp"
+#include "string_view.hpp"
 
 namespace rpc_core {
 namespace detail {
@@ -26,33 +26,50 @@ struct msg_wrapper : copyable {  // NOLINT
     ping = 1 << 3,
     pong = 1 << 4,
     no_such_cmd = 1 << 5,
+    // payload is records of other packages: [4 bytes length(little endian)][package]...
+    batch = 1 << 6,
+    // payload is compressed, see compressor
+    compressed = 1 << 7,
   };
 
   enum class response_state : uint8_t {
     response_sync = 1 << 0,
     response_async = 1 << 1,
     serialize_error = 1 << 2,
+    // handler sends responses itself, e.g. stream_response
+    response_stream = 1 << 3,
   };
 
   seq_type seq;
   cmd_type cmd;
+  // send cmd_id instead of cmd
+  bool with_cmd_id = false;
+  cmd_id_type cmd_id = 0;
   msg_type type;
   std::string data;
   std::string const* request_payload = nullptr;
+  // received cmd and data, point into the received package, only valid during dispatch
+  detail::string_view cmd_view;
+  detail::string_view data_view;
 
   response_state response_state;
   async_helper_s async_helper;
 
   std::string dump() const {
     char tmp[100];
-    snprintf(tmp, 100, "seq:%u, type:%u, cmd:%s", seq, type, cmd.c_str());
+    if (with_cmd_id) {
+      snprintf(tmp, 100, "seq:%u, type:%u, cmd_id:%08x", seq, type, cmd_id);
+    } else {
+      const detail::string_view c = cmd.empty() ? cmd_view : detail::string_view(cmd);
+      snprintf(tmp, 100, "seq:%u, type:%u, cmd:%.*s", seq, type, (int)c.size(), c.data());
+    }
     return tmp;
   }
 
   template <typename T>
   std::pair<bool, T> unpack_as() const {
     T message;
-    bool ok = deserialize(data, message);
+    bool ok = deserialize(data_view, message);
     if (!ok) {
       RPC_CORE_LOGE("deserialize error, msg info:%s", dump().c_str());
     }
@@ -79,6 +96,14 @@ struct msg_wrapper : copyable {  // NOLINT
     msg.response_state = success ? response_state::response_async : response_state::serialize_error;
     return std::make_pair(success, std::move(msg));
   }
+
+  static std::pair<bool, msg_wrapper> make_rsp_stream(seq_type seq, bool success = true) {
+    msg_wrapper msg;
+    msg.type = msg_wrapper::response;
+    msg.seq = seq;
+    msg.response_state = success ? response_state::response_stream : response_state::serialize_error;
+    return std::make_pair(success, std::move(msg));
+  }
 };
 
 }  // namespace detail
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "msg_wrapper.hpp"
+
+namespace rpc_core {
+namespace detail {
+
+/**
+ * waiting side of a request, msg_dispatcher keeps a weak reference to it for each pending seq
+ * so subscribe a response does not need to copy any callback.
+ */
+class rsp_handler {
+ public:
+  /**
+   * @return false if response deserialize error
+   */
+  virtual bool on_rsp(msg_wrapper msg) = 0;
+  virtual void on_timeout() = 0;
+
+ protected:
+  ~rsp_handler() = default;
+};
+
+}  // namespace detail
+}  // namespace rpc_core
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <string>
 
 namespace rpc_core {
@@ -8,6 +9,7 @@ namespace detail {
 
 class string_view {
  public:
+  string_view() = default;
   string_view(const char* data, size_t size) : data_(data), size_(size) {}
   string_view(const std::string& data) : data_(data.data()), size_(data.size()) {}  // NOLINT
   const char* data() const {
@@ -18,9 +20,13 @@ class string_view {
   }
 
  private:
-  const char* data_;
-  size_t size_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
 };
 
+inline bool operator==(const string_view& a, const string_view& b) {
+  return a.size() == b.size() && (a.size() == 0 || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
 }  // namespace detail
 }  // namespace rpc_core
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "../type.hpp"
+#include "flat_table.hpp"
+#include "noncopyable.hpp"
+#include "type_traits.hpp"
+
+namespace rpc_core {
+namespace detail {
+
+/**
+ * Hashed timing wheel for request timeout, driven by tick(now_ms).
+ * Entries are indexed by seq, so remove() is O(1) and memory is bounded by pending requests.
+ * Time starts from the first tick, timeout longer than one round stays in its slot for more rounds.
+ */
+class timing_wheel : noncopyable {
+  struct entry {
+    seq_type seq = 0;
+    uint64_t expire = 0;
+  };
+
+ public:
+  explicit timing_wheel(uint32_t tick_ms = 10, uint32_t slot_count = 512) : tick_ms_(tick_ms ? tick_ms : 1) {
+    size_t size = 1;
+    while (size < slot_count) size <<= 1;
+    slots_.resize(size);
+  }
+
+  /**
+   * the previous entry of seq is replaced
+   */
+  void add(seq_type seq, uint32_t timeout_ms) {
+    remove(seq);
+    entry e;
+    e.seq = seq;
+    e.expire = now_ + timeout_ms;
+    uint64_t tick = e.expire / tick_ms_;
+    if (tick <= tick_) tick = tick_ + 1;
+    const auto slot = (uint32_t)(tick & (slots_.size() - 1));
+    index_.insert(seq, location{seq, slot, (uint32_t)slots_[slot].size()});
+    slots_[slot].push_back(e);
+  }
+
+  /**
+   * O(1), no-op if seq is not in wheel
+   */
+  void remove(seq_type seq) {
+    auto loc = index_.find(seq, same_seq(seq));
+    if (loc == nullptr) return;
+    auto& slot = slots_[loc->slot];
+    const uint32_t pos = loc->pos;
+    index_.erase(seq, same_seq(seq));
+    if (pos + 1 != slot.size()) {
+      slot[pos] = slot.back();
+      index_.find(slot[pos].seq, same_seq(slot[pos].seq))->pos = pos;
+    }
+    slot.pop_back();
+  }
+
+  /**
+   * @param now_ms monotonic time in ms, wrap around is allowed
+   * @param expired seq of expired entries are appended to it
+   */
+  void tick(uint32_t now_ms, std::vector<seq_type>& expired) {
+    if (!started_) {
+      started_ = true;
+      last_ms_ = now_ms;
+      return;
+    }
+    now_ += static_cast<uint32_t>(now_ms - last_ms_);
+    last_ms_ = now_ms;
+
+    uint64_t target = now_ / tick_ms_;
+    if (target == tick_) return;
+    const uint64_t steps = detail::min<uint64_t>(target - tick_, slots_.size());
+    for (uint64_t i = 1; i <= steps; ++i) {
+      sweep(slots_[(tick_ + i) & (slots_.size() - 1)], expired);
+    }
+    tick_ = target;
+  }
+
+  size_t size() const {
+    return index_.size();
+  }
+
+ private:
+  struct location {
+    seq_type seq = 0;
+    uint32_t slot = 0;
+    uint32_t pos = 0;
+  };
+
+  struct same_seq {
+    explicit same_seq(seq_type seq) : seq(seq) {}
+    bool operator()(const location& loc) const {
+      return loc.seq == seq;
+    }
+    seq_type seq;
+  };
+
+  void sweep(std::vector<entry>& slot, std::vector<seq_type>& expired) {
+    uint32_t keep = 0;
+    for (auto& e : slot) {
+      if (e.expire <= now_) {
+        expired.push_back(e.seq);
+        index_.erase(e.seq, same_seq(e.seq));
+      } else {
+        if (&slot[keep] != &e) {
+          slot[keep] = e;
+          index_.find(e.seq, same_seq(e.seq))->pos = keep;
+        }
+        ++keep;
+      }
+    }
+    slot.resize(keep);
+  }
+
+ private:
+  const uint32_t tick_ms_;
+  std::vector<std::vector<entry>> slots_;
+  flat_table<location> index_;
+  bool started_ = false;
+  uint32_t last_ms_ = 0;
+  uint64_t now_ = 0;
+  uint64_t tick_ = 0;
+};
+
+}  // namespace detail
+}  // namespace rpc_core
@@ -1,54 +1,90 @@
 #pragma once
 
 #include <cstdint>
-#include <cstring>
-#include <string>
+
+#include "endian.hpp"
 
 namespace rpc_core {
 namespace detail {
 
 static const uint8_t MSB = 0x80;
-static const uint8_t MSB_ALL = ~0x7F;
 
-inline uint8_t* varint_encode(unsigned long long n, uint8_t* buf, uint8_t* bytes) {
-  uint8_t* ptr = buf;
-  while (n & MSB_ALL) {
-    *(ptr++) = (n & 0xFF) | MSB;
-    n = n >> 7;
+/**
+ * LEB128 varint, at most 10 bytes for uint64_t
+ */
+static const uint8_t VarintMaxBytes = 10;
+
+/**
+ * Write directly into buf, which should have VarintMaxBytes space.
+ * @return end of the written bytes
+ */
+inline uint8_t* varint_encode(uint64_t n, uint8_t* buf) {
+  while (n >= MSB) {
+    *buf++ = (uint8_t)(n | MSB);
+    n >>= 7;
   }
-  *ptr = n;
-  *bytes = ptr - buf + 1;
+  *buf++ = (uint8_t)n;
   return buf;
 }
 
-inline unsigned long long varint_decode(uint8_t* buf, uint8_t* bytes) {
-  unsigned long long result = 0;
-  int bits = 0;
-  uint8_t* ptr = buf;
-  unsigned long long ll;
-  while (*ptr & MSB) {
-    ll = *ptr;
-    result += ((ll & 0x7F) << bits);
-    ptr++;
-    bits += 7;
+namespace varint_impl {
+
+inline uint32_t ctz64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return (uint32_t)__builtin_ctzll(v);
+#else
+  uint32_t n = 0;
+  while (!(v & 1)) {
+    v >>= 1;
+    ++n;
   }
-  ll = *ptr;
-  result += ((ll & 0x7F) << bits);
-  *bytes = ptr - buf + 1;
-  return result;
+  return n;
+#endif
 }
 
-inline std::string to_varint(uint32_t var) {
-  uint8_t buf[sizeof(uint32_t) + 1];  // enough
-  std::string ret;
-  uint8_t bytes;
-  varint_encode(var, buf, &bytes);
-  return {(char*)buf, bytes};
+/**
+ * Gather the low 7 bits of each byte, software version of pext(word, 0x7f7f7f7f7f7f7f7f).
+ */
+inline uint64_t compact7(uint64_t word) {
+  word &= 0x7f7f7f7f7f7f7f7fULL;
+  word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+  word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+  word = (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+  return word;
 }
 
-inline uint32_t from_varint(void* data, uint8_t* bytes) {
-  return varint_decode((uint8_t*)data, bytes);
-  ;
+}  // namespace varint_impl
+
+/**
+ * Decode at most VarintMaxBytes bytes in [p, end).
+ * Varints up to 8 bytes are decoded with one load when 8 bytes are readable, without per-byte branches.
+ * @return end of the decoded bytes, nullptr if truncated or too long
+ */
+inline const uint8_t* varint_decode(const uint8_t* p, const uint8_t* end, uint64_t& value) {
+  if (p < end && !(*p & MSB)) {
+    value = *p;
+    return p + 1;
+  }
+  if (end - p >= 8) {
+    const uint64_t word = load_le<uint64_t>(p);
+    const uint64_t stop = ~word & 0x8080808080808080ULL;
+    if (stop) {
+      const uint32_t bytes = varint_impl::ctz64(stop) / 8 + 1;
+      const uint64_t mask = bytes == 8 ? ~0ULL : (1ULL << (bytes * 8)) - 1;
+      value = varint_impl::compact7(word & mask);
+      return p + bytes;
+    }
+  }
+  uint64_t result = 0;
+  for (uint32_t i = 0; i < VarintMaxBytes && p < end; ++i) {
+    const uint8_t b = *p++;
+    result |= (uint64_t)(b & 0x7f) << (i * 7);
+    if (!(b & MSB)) {
+      value = result;
+      return p;
+    }
+  }
+  return nullptr;
 }
 
 }  // namespace detail
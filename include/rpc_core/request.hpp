@@ -12,8 +12,10 @@
 
 // include
 #include "detail/callable/callable.hpp"
+#include "detail/cmd_id.hpp"
 #include "detail/msg_wrapper.hpp"
 #include "detail/noncopyable.hpp"
+#include "detail/rsp_handler.hpp"
 #include "result.hpp"
 #include "serialize.hpp"
 
@@ -24,7 +26,7 @@ using rpc_s = std::shared_ptr<rpc>;
 using rpc_w = std::weak_ptr<rpc>;
 class dispose;
 
-class request : detail::noncopyable, public std::enable_shared_from_this<request> {
+class request : detail::noncopyable, public detail::rsp_handler, public std::enable_shared_from_this<request> {
   friend class rpc;
 
  public:
@@ -45,6 +47,7 @@ class request : detail::noncopyable, public std::enable_shared_from_this<request
  public:
   request_s cmd(cmd_type cmd) {
     cmd_ = std::move(cmd);
+    cmd_id_ = detail::make_cmd_id(cmd_);
     return shared_from_this();
   }
 
@@ -138,6 +141,54 @@ class request : detail::noncopyable, public std::enable_shared_from_this<request
     return self;
   }
 
+  /**
+   * Stream response: cb(Item) is called for each item, and finally with normal after the last one.
+   * Peer should subscribe with stream_response<Req, Item>.
+   * timeout_ms is an idle timeout for stream: it finishes with timeout only if no item arrived within one period,
+   * so it fires between timeout_ms and 2 * timeout_ms after the last item. Stream is never retried.
+   * @param credit items peer can send before we consume them, credit is granted again after half of them consumed
+   */
+  template <typename F>
+  request_s rsp_stream(F cb, uint32_t credit = 16) {
+    static_assert(callable_traits<F>::argc == 1, "should be void(Item)");
+    using T = detail::remove_cvref_t<typename callable_traits<F>::template argument_type<0>>;
+
+    need_rsp_ = true;
+    is_stream_ = true;
+    stream_credit_ = credit ? credit : 1;
+    auto self = shared_from_this();
+    this->rsp_handle_ = [this, cb = std::move(cb)](detail::msg_wrapper msg) mutable {
+      if (canceled_) {
+        on_finish(finally_t::canceled);
+        return true;
+      }
+
+      if (msg.type & detail::msg_wrapper::msg_type::no_such_cmd) {
+        on_finish(finally_t::no_such_cmd);
+        return true;
+      }
+
+      // end of stream, payload is not empty if it is aborted by peer
+      if (!(msg.type & detail::msg_wrapper::msg_type::need_rsp)) {
+        on_finish(msg.data_view.size() == 0 ? finally_t::normal : finally_t::canceled);
+        return true;
+      }
+
+      auto item = msg.unpack_as<T>();
+      if (item.first) {
+        stream_active_ = true;
+        cb(std::move(item.second));
+        consume_stream_item();
+        return true;
+      } else {
+        cancel_stream();
+        on_finish(finally_t::rsp_serialize_error);
+        return false;
+      }
+    };
+    return self;
+  }
+
   /**
    * one call, one finally
    * @param finally
@@ -191,6 +242,9 @@ class request : detail::noncopyable, public std::enable_shared_from_this<request
   inline request_s add_to(dispose& dispose);
 
   request_s cancel() {
+    if (is_stream_ && waiting_rsp_) {
+      cancel_stream();
+    }
     canceled(true);
     on_finish(finally_t::canceled);
     return shared_from_this();
@@ -289,6 +343,38 @@ class request : detail::noncopyable, public std::enable_shared_from_this<request
   }
 
  private:
+  bool on_rsp(detail::msg_wrapper msg) override {
+    if (!rsp_handle_) {
+      RPC_CORE_LOGE("rsp can not be null");
+      return false;
+    }
+    return rsp_handle_(std::move(msg));
+  }
+
+  void on_timeout() override {
+    if (is_stream_) {
+      if (stream_active_ && waiting_rsp_ && !canceled_) {
+        stream_active_ = false;
+        rearm_timeout();
+        return;
+      }
+      cancel_stream();
+      // retry would restart the stream from the beginning
+      retry_count_ = 0;
+    }
+    if (timeout_cb_) {
+      timeout_cb_();
+    }
+  }
+
+  inline void rearm_timeout();
+
+  inline void release_window();
+
+  inline void cancel_stream();
+
+  inline void consume_stream_item();
+
   void on_finish(finally_t type) {
     if (!waiting_rsp_) return;
     waiting_rsp_ = false;
@@ -297,6 +383,7 @@ class request : detail::noncopyable, public std::enable_shared_from_this<request
     if (finally_) {
       finally_(finally_type_);
     }
+    release_window();
     self_keeper_ = nullptr;
   }
 
@@ -305,6 +392,7 @@ class request : detail::noncopyable, public std::enable_shared_from_this<request
   request_s self_keeper_;
   seq_type seq_{};
   cmd_type cmd_;
+  cmd_id_type cmd_id_ = detail::make_cmd_id(cmd_type());
   std::string payload_;
   bool need_rsp_ = false;
   bool canceled_ = false;
@@ -316,6 +404,11 @@ class request : detail::noncopyable, public std::enable_shared_from_this<request
   int retry_count_ = 0;
   bool waiting_rsp_ = false;
   bool is_ping_ = false;
+  bool in_window_ = false;
+  bool is_stream_ = false;
+  uint32_t stream_credit_ = 0;
+  uint32_t stream_consumed_ = 0;
+  bool stream_active_ = false;
 };
 
 using request_s = request::request_s;
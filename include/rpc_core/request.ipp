@@ -33,6 +33,41 @@ void request::call(const rpc_s& rpc) {
   }
 }
 
+void request::release_window() {
+  if (!in_window_) return;
+  auto r = rpc_.lock();
+  if (r) {
+    r->window_release(this);
+  } else {
+    in_window_ = false;
+  }
+}
+
+void request::rearm_timeout() {
+  auto r = rpc_.lock();
+  if (r) {
+    r->rearm_timeout(this);
+  } else {
+    on_finish(finally_t::rpc_expired);
+  }
+}
+
+void request::cancel_stream() {
+  auto r = rpc_.lock();
+  if (r) {
+    r->send_stream_cancel(seq_);
+  }
+}
+
+void request::consume_stream_item() {
+  if (++stream_consumed_ < (stream_credit_ + 1) / 2) return;
+  auto r = rpc_.lock();
+  if (r) {
+    r->send_stream_credit(seq_, stream_consumed_);
+  }
+  stream_consumed_ = 0;
+}
+
 request_s request::add_to(dispose& dispose) {
   auto self = shared_from_this();
   dispose.add(self);
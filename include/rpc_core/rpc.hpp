@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
@@ -9,9 +10,11 @@
 // include
 #include "connection.hpp"
 #include "detail/callable/callable.hpp"
+#include "detail/lock.hpp"
 #include "detail/msg_dispatcher.hpp"
 #include "detail/noncopyable.hpp"
 #include "request_response.hpp"
+#include "stream_response.hpp"
 
 namespace rpc_core {
 
@@ -51,12 +54,117 @@ class rpc : detail::noncopyable, public std::enable_shared_from_this<rpc> {
     dispatcher_->set_timer_impl(std::move(timer_impl));
   }
 
+  /**
+   * Use built-in timing wheel for request timeout instead of set_timer(), no timer is created per request.
+   * tick() should be called periodically on the rpc thread.
+   * @param tick_ms timeout precision
+   * @param slot_count slots of one round, rounded up to power of 2
+   */
+  inline void set_timing_wheel(uint32_t tick_ms = 10, uint32_t slot_count = 512) {
+    dispatcher_->enable_timing_wheel(tick_ms, slot_count);
+  }
+
+  /**
+   * Drive timing wheel, expired requests will timeout in batch.
+   * @param now_ms monotonic time in ms
+   */
+  inline void tick(uint32_t now_ms) {
+    dispatcher_->tick(now_ms);
+  }
+
+  /**
+   * Send responses produced while handling one read(between connection's on_recv_begin/on_recv_end) as one package.
+   * stream_connection supports it, enable it only when the peer supports batch.
+   * @param max_bytes flush the batch early when it is larger than this
+   */
+  inline void set_batch_response(bool enable, size_t max_bytes = 64 * 1024) {
+    dispatcher_->set_batch_response(enable, max_bytes);
+  }
+
+  /**
+   * Compress payloads not smaller than threshold with the bundled lz, incompressible payloads are sent as is.
+   * Compressed package is marked in msg type, peer should enable decompression by set_compression or set_decompression.
+   */
+  inline void set_compression(size_t threshold = 256) {
+    dispatcher_->set_compressor(detail::lz_compressor(), threshold);
+  }
+
+  /**
+   * Use custom compressor, peer should register the same compressor id to decompress.
+   */
+  inline void set_compressor(detail::compressor compressor, size_t threshold = 256) {
+    dispatcher_->set_compressor(std::move(compressor), threshold);
+  }
+
+  inline void disable_compression() {
+    dispatcher_->disable_compressor();
+  }
+
+  /**
+   * Accept compressed packages without compressing the sent ones, disabled by default.
+   * set_compression/set_compressor enable it with 1 MB limit if it was not enabled.
+   * @param max_raw_size compressed packages larger than it after decompress are dropped, 0 means disable
+   */
+  inline void set_decompression(size_t max_raw_size = detail::msg_dispatcher::DefaultMaxRawSize) {
+    dispatcher_->set_decompression(max_raw_size);
+  }
+
+  /**
+   * Deserialize messages into a per-rpc arena, which is reset in O(1) after the handler returns.
+   * Only arena_string/arena_vector/arena_map(or containers with arena_allocator) allocate from it.
+   * They and their moves must not escape the handler, e.g. by request_response of async or scheduler handler,
+   * a copy of them is allocated from heap and can be kept.
+   * Should not be called in handler, it is ignored.
+   * @param block_size 0 means disable
+   */
+  inline void set_arena(size_t block_size = 4096) {
+    dispatcher_->set_arena(block_size);
+  }
+
+  /**
+   * Limit requests waiting for response, more requests are queued locally and sent in order as responses arrive.
+   * Notice: timeout of queued request starts when it is actually sent.
+   * @param max_requests 0 means no limit
+   * @param max_bytes payload bytes of requests waiting for response, 0 means no limit
+   */
+  inline void set_window(uint32_t max_requests, size_t max_bytes = 0) {
+    window_max_requests_ = max_requests;
+    window_max_bytes_ = max_bytes;
+  }
+
+  /**
+   * Called when the window was full and all queued requests have been sent, producers can continue.
+   */
+  inline void on_window_open(std::function<void()> cb) {
+    on_window_open_ = std::move(cb);
+  }
+
+  inline bool is_window_full() {
+    detail::lock_guard lock(window_mutex_);
+    return !window_queue_.empty() || window_full_for(0);
+  }
+
+  inline size_t window_queued_size() {
+    detail::lock_guard lock(window_mutex_);
+    return window_queue_.size();
+  }
+
   inline void set_ready(bool ready) {
     is_ready_ = ready;
   }
 
+  /**
+   * Send cmd id(4 bytes hash of cmd) instead of cmd string, saves bytes for long cmd.
+   * Subscribers always accept both, enable it only when the peer supports cmd id.
+   * If subscribed cmds of the peer have the same id, requests of them by id get no_such_cmd.
+   */
+  inline void set_use_cmd_id(bool use) {
+    use_cmd_id_ = use;
+  }
+
  public:
-  template <typename F, typename std::enable_if<!detail::fp_is_request_response<F>::value, int>::type = 0>
+  template <typename F,
+            typename std::enable_if<!detail::fp_is_request_response<F>::value && !detail::fp_is_stream_response<F>::value, int>::type = 0>
   void subscribe(const cmd_type& cmd, F handle) {
     constexpr bool F_ReturnIsEmpty = std::is_void<typename detail::callable_traits<F>::return_type>::value;
     constexpr bool F_ParamIsEmpty = detail::callable_traits<F>::argc == 0;
@@ -81,6 +189,7 @@ class rpc : detail::noncopyable, public std::enable_shared_from_this<rpc> {
       static_assert(detail::is_request_response<request_response>::value, "should be request_response<>");
       using Req = decltype(request_response_impl::req);
       using Rsp = typename request_response_impl::RspType;
+      static_assert(!detail::is_view_type<Req>::value, "request_response may outlive the package, Req should not be view type");
       request_response rr = request_response_impl::create();
       auto r = msg.unpack_as<Req>();
       // notice lifecycle: request_response hold async_helper
@@ -116,6 +225,38 @@ class rpc : detail::noncopyable, public std::enable_shared_from_this<rpc> {
     });
   }
 
+  /**
+   * Stream response: handle(stream_response<Req, Item>), write items and end() at any time later.
+   * Peer should call with request::rsp_stream().
+   */
+  template <typename F, typename std::enable_if<detail::fp_is_stream_response<F>::value, int>::type = 0>
+  void subscribe(const cmd_type& cmd, F handle) {
+    static_assert(std::is_void<typename detail::callable_traits<F>::return_type>::value, "should return void");
+    init_stream();
+    dispatcher_->subscribe_cmd(cmd, [handle = std::move(handle), dispatcher = std::weak_ptr<detail::msg_dispatcher>(dispatcher_),
+                                     registry = std::weak_ptr<detail::stream_registry>(stream_registry_)](const detail::msg_wrapper& msg) mutable {
+      using stream_response = detail::remove_cvref_t<typename detail::callable_traits<F>::template argument_type<0>>;
+      using stream_response_impl = typename stream_response::element_type;
+      using Req = decltype(stream_response_impl::req);
+      static_assert(!detail::is_view_type<Req>::value, "stream_response outlives the package, Req should not be view type");
+      auto r = msg.unpack_as<Req>();
+      if (!r.first) {
+        return detail::msg_wrapper::make_rsp_stream(msg.seq, false);
+      }
+      stream_response s = stream_response_impl::create();
+      s->req = std::move(r.second);
+      s->seq_ = msg.seq;
+      s->dispatcher_ = dispatcher;
+      s->registry_ = registry;
+      auto reg = registry.lock();
+      if (reg) {
+        reg->add(msg.seq, s);
+      }
+      handle(std::move(s));
+      return detail::msg_wrapper::make_rsp_stream(msg.seq);
+    });
+  }
+
   inline void unsubscribe(const cmd_type& cmd) {
     dispatcher_->unsubscribe_cmd(cmd);
   }
@@ -154,12 +295,68 @@ class rpc : detail::noncopyable, public std::enable_shared_from_this<rpc> {
     return seq_++;
   }
 
-  inline void send_request(request const* request);
+  inline void send_request(request* request);
+
+  /**
+   * Called by request of stream response.
+   */
+  inline void send_stream_credit(seq_type seq, uint32_t credit);
+
+  inline void send_stream_cancel(seq_type seq);
+
+  /**
+   * Called by stream request when items arrived within the timeout period.
+   */
+  inline void rearm_timeout(request* request);
+
+  /**
+   * Called by request when it finished, release its place in window.
+   */
+  inline void window_release(request* request);
 
   inline bool is_ready() const {
     return is_ready_;
   }
 
+  /**
+   * requests waiting for response
+   */
+  inline size_t pending_size() const {
+    return dispatcher_->pending_size();
+  }
+
+ private:
+  void init_stream() {
+    if (stream_registry_) return;
+    stream_registry_ = std::make_shared<detail::stream_registry>();
+    std::weak_ptr<detail::stream_registry> registry = stream_registry_;
+    subscribe(detail::StreamCreditCmd, [registry](const std::pair<seq_type, uint32_t>& credit) {
+      auto reg = registry.lock();
+      auto handler = reg ? reg->find(credit.first) : nullptr;
+      if (handler) {
+        handler->add_credit(credit.second);
+      }
+    });
+    subscribe(detail::StreamCancelCmd, [registry](seq_type seq) {
+      auto reg = registry.lock();
+      auto handler = reg ? reg->find(seq) : nullptr;
+      if (handler) {
+        handler->peer_cancel();
+      }
+    });
+  }
+
+  inline bool window_acquire(request* request);
+
+  inline void window_drain();
+
+  inline bool window_full_for(size_t bytes) const {
+    if (window_max_requests_ && window_requests_ >= window_max_requests_) return true;
+    // always allow one request larger than max_bytes
+    if (window_max_bytes_ && window_requests_ && window_bytes_ + bytes > window_max_bytes_) return true;
+    return false;
+  }
+
  private:
   template <typename F, bool F_ReturnIsEmpty, bool F_ParamIsEmpty>
   struct subscribe_helper;
@@ -221,8 +418,22 @@ class rpc : detail::noncopyable, public std::enable_shared_from_this<rpc> {
  private:
   std::shared_ptr<connection> conn_;
   std::shared_ptr<detail::msg_dispatcher> dispatcher_;
-  seq_type seq_{0};
-  bool is_ready_ = false;
+  detail::atomic<seq_type> seq_{0};
+  detail::atomic<bool> is_ready_{false};
+  bool use_cmd_id_ = false;
+
+  std::shared_ptr<detail::stream_registry> stream_registry_;
+
+  // window
+  uint32_t window_max_requests_ = 0;
+  size_t window_max_bytes_ = 0;
+  uint32_t window_requests_ = 0;
+  size_t window_bytes_ = 0;
+  bool window_was_full_ = false;
+  bool window_draining_ = false;
+  std::deque<request_s> window_queue_;
+  std::function<void()> on_window_open_;
+  detail::mutex window_mutex_;
 };
 
 using rpc_s = std::shared_ptr<rpc>;
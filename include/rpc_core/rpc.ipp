@@ -39,18 +39,102 @@ inline asio::awaitable<result<R>> rpc::co_call(cmd_type cmd, Msg&& message) {
 }
 #endif
 
-void rpc::send_request(request const* request) {
+void rpc::send_request(request* request) {
+  if (request->need_rsp_ && !window_acquire(request)) {
+    RPC_CORE_LOGD("window full, queue cmd:%s", request->cmd_.c_str());
+    return;
+  }
   if (request->need_rsp_) {
-    dispatcher_->subscribe_rsp(request->seq_, request->rsp_handle_, request->timeout_cb_, request->timeout_ms_);
+    dispatcher_->subscribe_rsp(request->seq_, request->self_keeper_, request->timeout_ms_);
   }
   detail::msg_wrapper msg;
   msg.type = static_cast<detail::msg_wrapper::msg_type>(detail::msg_wrapper::command | (request->is_ping_ ? detail::msg_wrapper::ping : 0) |
                                                         (request->need_rsp_ ? detail::msg_wrapper::need_rsp : 0));
-  msg.cmd = request->cmd_;
+  if (use_cmd_id_ && !request->is_ping_) {
+    msg.with_cmd_id = true;
+    msg.cmd_id = request->cmd_id_;
+  } else {
+    msg.cmd = request->cmd_;
+  }
   msg.seq = request->seq_;
   msg.request_payload = &request->payload_;
-  RPC_CORE_LOGD("=> seq:%u type:%s %s", msg.seq, (msg.type & detail::msg_wrapper::msg_type::ping) ? "ping" : "cmd", msg.cmd.c_str());
-  conn_->send_package_impl(detail::coder::serialize(msg));
+  RPC_CORE_LOGD("=> seq:%u type:%s %s", msg.seq, (msg.type & detail::msg_wrapper::msg_type::ping) ? "ping" : "cmd", request->cmd_.c_str());
+  dispatcher_->send_msg(msg);
+  if (request->is_stream_ && !request->is_ping_) {
+    request->stream_consumed_ = 0;
+    request->stream_active_ = false;
+    send_stream_credit(request->seq_, request->stream_credit_);
+  }
+}
+
+void rpc::rearm_timeout(request* request) {
+  dispatcher_->subscribe_rsp(request->seq_, request->self_keeper_, request->timeout_ms_);
+}
+
+void rpc::send_stream_credit(seq_type seq, uint32_t credit) {
+  cmd(detail::StreamCreditCmd)->msg(std::make_pair(seq, credit))->call();
+}
+
+void rpc::send_stream_cancel(seq_type seq) {
+  // peer sends no end response for it
+  dispatcher_->unsubscribe_rsp(seq);
+  cmd(detail::StreamCancelCmd)->msg(seq)->call();
+}
+
+bool rpc::window_acquire(request* request) {
+  if (request->in_window_) return true;  // retry
+  if (window_max_requests_ == 0 && window_max_bytes_ == 0) return true;
+  detail::lock_guard lock(window_mutex_);
+  const size_t bytes = request->payload_.size();
+  if (!window_queue_.empty() || window_full_for(bytes)) {
+    window_queue_.push_back(request->self_keeper_);
+    window_was_full_ = true;
+    return false;
+  }
+  ++window_requests_;
+  window_bytes_ += bytes;
+  request->in_window_ = true;
+  return true;
+}
+
+void rpc::window_release(request* request) {
+  if (!request->in_window_) return;
+  request->in_window_ = false;
+  {
+    detail::lock_guard lock(window_mutex_);
+    --window_requests_;
+    window_bytes_ -= request->payload_.size();
+    if (window_draining_) return;
+    window_draining_ = true;
+  }
+  window_drain();
+}
+
+void rpc::window_drain() {
+  auto self = shared_from_this();
+  for (;;) {
+    request_s next;
+    {
+      detail::lock_guard lock(window_mutex_);
+      if (window_queue_.empty() || window_full_for(window_queue_.front()->payload_.size())) {
+        window_draining_ = false;
+        if (!window_was_full_ || !window_queue_.empty()) return;
+        window_was_full_ = false;
+        break;
+      }
+      next = std::move(window_queue_.front());
+      window_queue_.pop_front();
+      // canceled while queued
+      if (!next->waiting_rsp_) continue;
+      ++window_requests_;
+      window_bytes_ += next->payload_.size();
+      next->in_window_ = true;
+    }
+    send_request(next.get());
+  }
+  if (on_window_open_) {
+    on_window_open_();
+  }
 }
 
 }  // namespace rpc_core
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// config
+#include "config.hpp"
+
+// include
+#include "detail/cmd_id.hpp"
+#include "detail/lock.hpp"
+#include "detail/noncopyable.hpp"
+#include "request.hpp"
+#include "rpc.hpp"
+
+namespace rpc_core {
+
+/**
+ * Group of rpc to the same peer, usually one rpc per connection/thread.
+ * All rpc share the subscribed cmds, and cmd() is routed to one of them by policy.
+ * Notice: add/remove/subscribe should be done before calling from multiple threads.
+ */
+class rpc_pool : detail::noncopyable {
+ public:
+  enum class policy : uint8_t {
+    round_robin,
+    least_outstanding,
+    key_hash,
+  };
+
+  struct stats {
+    size_t rpc_count = 0;
+    size_t ready_count = 0;
+    size_t pending_count = 0;
+    uint64_t routed_count = 0;
+  };
+
+ public:
+  static std::shared_ptr<rpc_pool> create(policy p = policy::round_robin) {
+    struct helper : public rpc_pool {
+      explicit helper(policy p) : rpc_pool(p) {}
+    };
+    return std::make_shared<helper>(p);
+  }
+
+ private:
+  explicit rpc_pool(policy p) : policy_(p) {}
+
+ public:
+  /**
+   * add rpc and apply all subscribed cmds to it
+   */
+  void add(rpc_s rpc) {
+    for (const auto& item : subscribes_) {
+      item.second(*rpc);
+    }
+    rpcs_.push_back(std::move(rpc));
+  }
+
+  void remove(const rpc_s& rpc) {
+    for (auto it = rpcs_.begin(); it != rpcs_.end(); ++it) {
+      if (*it == rpc) {
+        rpcs_.erase(it);
+        return;
+      }
+    }
+  }
+
+  inline size_t size() const {
+    return rpcs_.size();
+  }
+
+  inline const std::vector<rpc_s>& rpcs() const {
+    return rpcs_;
+  }
+
+  inline void set_policy(policy p) {
+    policy_ = p;
+  }
+
+ public:
+  /**
+   * same as rpc::subscribe, handle is copied to each rpc
+   */
+  template <typename F>
+  void subscribe(const cmd_type& cmd, F handle) {
+    auto apply = [cmd, handle = std::move(handle)](rpc& rpc) {
+      rpc.subscribe(cmd, handle);
+    };
+    for (const auto& rpc : rpcs_) {
+      apply(*rpc);
+    }
+    subscribes_[cmd] = std::move(apply);
+  }
+
+  void unsubscribe(const cmd_type& cmd) {
+    subscribes_.erase(cmd);
+    for (const auto& rpc : rpcs_) {
+      rpc->unsubscribe(cmd);
+    }
+  }
+
+ public:
+  /**
+   * create request on the rpc selected by policy, for key_hash policy it is the same as round_robin
+   * request of empty pool is bound to no rpc, it finishes with rpc_expired
+   */
+  inline request_s cmd(cmd_type cmd) {
+    return create_request(select())->cmd(std::move(cmd));
+  }
+
+  /**
+   * requests with the same key are always routed to the same rpc, to keep their order
+   */
+  inline request_s cmd(cmd_type cmd, const std::string& key) {
+    return create_request(select(key))->cmd(std::move(cmd));
+  }
+
+  /**
+   * @return nullptr if pool is empty
+   */
+  rpc_s select() {
+    if (rpcs_.empty()) return nullptr;
+    ++routed_count_;
+    if (policy_ == policy::least_outstanding) {
+      return select_least_outstanding();
+    }
+    return select_round_robin();
+  }
+
+  rpc_s select(const std::string& key) {
+    if (policy_ != policy::key_hash) return select();
+    if (rpcs_.empty()) return nullptr;
+    ++routed_count_;
+    return rpcs_[detail::make_cmd_id(key) % rpcs_.size()];
+  }
+
+  stats get_stats() const {
+    stats s;
+    s.rpc_count = rpcs_.size();
+    for (const auto& rpc : rpcs_) {
+      if (rpc->is_ready()) ++s.ready_count;
+      s.pending_count += rpc->pending_size();
+    }
+    s.routed_count = routed_count_;
+    return s;
+  }
+
+ private:
+  static request_s create_request(const rpc_s& rpc) {
+    return rpc ? rpc->create_request() : request::create();
+  }
+
+  rpc_s select_round_robin() {
+    const size_t size = rpcs_.size();
+    const size_t start = next_++;
+    for (size_t i = 0; i < size; ++i) {
+      auto& rpc = rpcs_[(start + i) % size];
+      if (rpc->is_ready()) return rpc;
+    }
+    // let request finish with rpc_not_ready
+    return rpcs_[start % size];
+  }
+
+  rpc_s select_least_outstanding() {
+    const rpc_s* best = nullptr;
+    size_t best_pending = 0;
+    for (const auto& rpc : rpcs_) {
+      if (!rpc->is_ready()) continue;
+      size_t pending = rpc->pending_size();
+      if (best == nullptr || pending < best_pending) {
+        best = &rpc;
+        best_pending = pending;
+      }
+    }
+    return best ? *best : rpcs_.front();
+  }
+
+ private:
+  policy policy_;
+  std::vector<rpc_s> rpcs_;
+  std::map<cmd_type, std::function<void(rpc&)>> subscribes_;
+  detail::atomic<size_t> next_{0};
+  detail::atomic<uint64_t> routed_count_{0};
+};
+
+using rpc_pool_s = std::shared_ptr<rpc_pool>;
+
+}  // namespace rpc_core
@@ -41,6 +41,7 @@
 #include "serialize/type_enum.hpp"
 #include "serialize/type_ptr.hpp"
 #include "serialize/type_struct.hpp"
+#include "serialize/type_view.hpp"
 #include "serialize/type_void.hpp"
 
 #endif
@@ -22,16 +22,23 @@ inline serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<std::is_same<T, binary_wrap>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  t.size >> sa;
+  sa.size += t.size;
+  return sa;
+}
+
 template <typename T, typename std::enable_if<std::is_same<T, binary_wrap>::value, int>::type = 0>
 inline serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   t.size << ia;
+  if (!ia.require(t.size)) return ia;
   t._data_ = std::shared_ptr<uint8_t>(new uint8_t[t.size], [](const uint8_t* p) {
     delete[] p;
   });
   t.data = t._data_.get();
   memcpy(t.data, ia.data, t.size);
-  ia.data += t.size;
-  ia.size -= t.size;
+  ia.advance(t.size);
   return ia;
 }
 
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
+#include <type_traits>
 
 namespace rpc_core {
 namespace detail {
@@ -12,51 +13,88 @@ template <typename int_impl_t>
 struct auto_size_type {
   explicit auto_size_type(int_impl_t value = 0) : value(value) {}
 
-  std::string serialize() const {
-    if (value == 0) {
-      return {(char*)&value, 1};
-    }
+  /**
+   * encoded: [negative(1 bit) | effective bytes(7 bits)][effective bytes of abs value, little endian]
+   */
+  static const uint8_t MaxBytes = 1 + sizeof(int_impl_t);
 
-    uint8_t effective_bytes = sizeof(int_impl_t);
+  /**
+   * @param buf at least MaxBytes
+   * @return bytes written
+   */
+  uint8_t serialize(void* buf) const {
+    auto data = (uint8_t*)buf;
+    const uint8_t effective_bytes = this->effective_bytes();
+    data[0] = effective_bytes;
+    if (effective_bytes == 0) {
+      return 1;
+    }
     auto value_tmp = value;
     if (value_tmp < 0) {
       value_tmp = ~value_tmp + 1;
-    }
-    for (int i = sizeof(int_impl_t) - 1; i >= 0; --i) {
-      if ((value_tmp >> (i * 8)) & 0xff) {
-        break;
-      } else {
-        --effective_bytes;
-      }
-    }
-
-    std::string ret;
-    ret.resize(1 + effective_bytes);
-    auto data = (uint8_t*)ret.data();
-    data[0] = effective_bytes;
-    memcpy(data + 1, &value_tmp, effective_bytes);
-    if (value < 0) {
       data[0] |= 0x80;
     }
-    return ret;
+    memcpy(data + 1, &value_tmp, effective_bytes);
+    return 1 + effective_bytes;
+  }
+
+  uint8_t serialized_size() const {
+    return 1 + effective_bytes();
   }
 
+  std::string serialize() const {
+    char buf[MaxBytes];
+    return {buf, serialize(buf)};
+  }
+
+  /**
+   * trust size_bytes in data, prefer the bounded one
+   */
   int deserialize(const void* data) {
-    auto p = (uint8_t*)data;
-    uint8_t size_bytes = p[0];
-    bool negative = false;
-    if (size_bytes & 0x80) {
-      negative = true;
-      size_bytes &= 0x7f;
+    return deserialize(data, 1 + (*(const uint8_t*)data & 0x7f));
+  }
+
+  /**
+   * @param size readable bytes of data
+   * @return bytes consumed, 0 if size_bytes is invalid or exceeds size
+   */
+  int deserialize(const void* data, size_t size) {
+    using uint_impl_t = typename std::make_unsigned<int_impl_t>::type;
+    auto p = (const uint8_t*)data;
+    if (size == 0) return 0;
+    const uint8_t size_bytes = p[0] & 0x7f;
+    if (size_bytes > sizeof(int_impl_t) || size_bytes >= size) return 0;
+    uint_impl_t v = 0;
+    if (size >= MaxBytes) {
+      // fixed size load and mask instead of variable length copy
+      memcpy(&v, p + 1, sizeof(v));
+      if (size_bytes < sizeof(v)) {
+        v &= ((uint_impl_t)1 << (size_bytes * 8)) - 1;
+      }
+    } else {
+      memcpy(&v, p + 1, size_bytes);
     }
-    memcpy(&value, p + 1, size_bytes);
-    if (negative) {
+    value = (int_impl_t)v;
+    if (p[0] & 0x80) {
       value = ~value + 1;
     }
     return size_bytes + 1;
   }
 
   int_impl_t value;
+
+ private:
+  uint8_t effective_bytes() const {
+    auto value_tmp = value;
+    if (value_tmp < 0) {
+      value_tmp = ~value_tmp + 1;
+    }
+    uint8_t bytes = 0;
+    while (bytes < sizeof(int_impl_t) && (value_tmp >> (bytes * 8)) != 0) {
+      ++bytes;
+    }
+    return bytes;
+  }
 };
 
 using auto_size = auto_size_type<size_t>;
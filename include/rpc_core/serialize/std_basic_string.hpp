@@ -32,10 +32,20 @@ inline serialize_oarchive& operator>>(T&& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_basic_string<T>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  sa.size += t.size() * sizeof(typename T::value_type);
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_basic_string<T>::value, int>::type = 0>
 inline serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   using VT = typename T::value_type;
-  t = T((VT*)(ia.data), ia.size / sizeof(VT));
+  if (ia.error) return ia;
+  // takes all remaining bytes
+  const size_t count = ia.size / sizeof(VT);
+  t = count ? T((VT*)(ia.data), count) : T();
+  ia.advance(count * sizeof(VT));
   return ia;
 }
 
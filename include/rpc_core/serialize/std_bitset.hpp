@@ -22,10 +22,21 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_bitset<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  sa.size += t.size();
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_bitset<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   std::string tmp;
   tmp << ia;
+  // bitset constructor throws on invalid char
+  if (tmp.find_first_not_of("01") != std::string::npos) {
+    ia.error = true;
+    return ia;
+  }
   t = T(std::move(tmp));
   return ia;
 }
@@ -28,6 +28,12 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_chrono_duration<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::auto_intmax(t.count()) >> sa;
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_chrono_duration<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   detail::auto_intmax rep;
@@ -42,6 +48,12 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_chrono_time_point<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  t.time_since_epoch() >> sa;
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_chrono_time_point<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   typename T::duration duration;
@@ -28,6 +28,13 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_complex<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  sa & t.real();
+  sa & t.imag();
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_complex<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   using VT = typename T::value_type;
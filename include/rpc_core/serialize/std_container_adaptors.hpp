@@ -27,6 +27,12 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_stack<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::add_serialized_size((const typename T::container_type&)t, sa);
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_stack<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   (typename T::container_type&)t << ia;
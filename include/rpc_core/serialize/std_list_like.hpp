@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstring>
 #include <deque>
 #include <list>
 #include <vector>
@@ -20,9 +21,105 @@ struct is_std_list_like<std::list<Args...>> : std::true_type {};
 template <typename... Args>
 struct is_std_list_like<std::deque<Args...>> : std::true_type {};
 
+template <typename T>
+struct is_raw_std_vector : std::false_type {};
+
+template <typename T, typename Alloc>
+struct is_raw_std_vector<std::vector<T, Alloc>> : is_raw_wire_type<T> {};
+
+template <typename T>
+struct is_pod_std_vector : std::false_type {};
+
+template <typename T, typename Alloc>
+struct is_pod_std_vector<std::vector<T, Alloc>> : is_pod_on_wire<T> {};
+
 }  // namespace detail
 
-template <typename T, typename std::enable_if<detail::is_std_list_like<T>::value, int>::type = 0>
+template <typename T, typename std::enable_if<detail::is_raw_std_vector<T>::value, int>::type = 0>
+serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
+  detail::auto_size size(t.size());
+  size >> oa;
+  detail::serialize_raw_array(t.data(), t.size(), oa);
+  return oa;
+}
+
+template <typename T, typename std::enable_if<detail::is_raw_std_vector<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::auto_size(t.size()) >> sa;
+  sa.size += t.size() * sizeof(typename T::value_type);
+  return sa;
+}
+
+template <typename T, typename std::enable_if<detail::is_raw_std_vector<T>::value, int>::type = 0>
+serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
+  detail::auto_size size;
+  size << ia;
+  if (ia.error || size.value > ia.size / sizeof(typename T::value_type)) {
+    ia.error = true;
+    return ia;
+  }
+  const size_t offset = t.size();
+  t.resize(offset + size.value);
+  detail::deserialize_raw_array(t.data() + offset, size.value, ia);
+  return ia;
+}
+
+/**
+ * vector of pod on wire struct: items have the same size prefix, copy each item by memcpy
+ */
+template <typename T, typename std::enable_if<detail::is_pod_std_vector<T>::value, int>::type = 0>
+serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
+  using value_type = typename T::value_type;
+  detail::auto_size(t.size()) >> oa;
+  uint8_t prefix[detail::auto_size::MaxBytes];
+  const uint8_t prefix_size = detail::auto_size(sizeof(value_type)).serialize(prefix);
+  const size_t stride = prefix_size + sizeof(value_type);
+  const size_t offset = oa.data.size();
+  oa.data.resize(offset + stride * t.size());
+  char* p = &oa.data[offset];
+  for (const auto& item : t) {
+    memcpy(p, prefix, prefix_size);
+    memcpy(p + prefix_size, &item, sizeof(value_type));
+    p += stride;
+  }
+  return oa;
+}
+
+template <typename T, typename std::enable_if<detail::is_pod_std_vector<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  using value_type = typename T::value_type;
+  detail::auto_size(t.size()) >> sa;
+  sa.size += t.size() * (detail::auto_size(sizeof(value_type)).serialized_size() + sizeof(value_type));
+  return sa;
+}
+
+template <typename T, typename std::enable_if<detail::is_pod_std_vector<T>::value, int>::type = 0>
+serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
+  using value_type = typename T::value_type;
+  detail::auto_size size;
+  size << ia;
+  if (ia.error || size.value > ia.size / (1 + sizeof(value_type))) {
+    ia.error = true;
+    return ia;
+  }
+  size_t i = t.size();
+  t.resize(i + size.value);
+  for (; i < t.size(); ++i) {
+    detail::auto_size item_size;
+    const int cost = item_size.deserialize(ia.data, ia.size);
+    if (cost == 0 || item_size.value != sizeof(value_type)) {
+      ia.error = true;
+      break;
+    }
+    ia.advance(cost);
+    if (!detail::deserialize_raw_array(&t[i], 1, ia)) break;
+  }
+  return ia;
+}
+
+template <typename T,
+          typename std::enable_if<detail::is_std_list_like<T>::value && !detail::is_raw_std_vector<T>::value && !detail::is_pod_std_vector<T>::value,
+                                  int>::type = 0>
 serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   detail::auto_size size(t.size());
   size >> oa;
@@ -30,25 +127,45 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
     if (std::is_fundamental<detail::remove_cvref_t<decltype(item)>>::value) {
       item >> oa;
     } else {
-      serialize_oarchive tmp;
-      item >> tmp;
-      tmp >> oa;
+      detail::serialize_with_size(item, oa);
     }
   }
   return oa;
 }
 
-template <typename T, typename std::enable_if<detail::is_std_list_like<T>::value, int>::type = 0>
+template <typename T,
+          typename std::enable_if<detail::is_std_list_like<T>::value && !detail::is_raw_std_vector<T>::value && !detail::is_pod_std_vector<T>::value,
+                                  int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::auto_size(t.size()) >> sa;
+  for (auto& item : t) {
+    if (std::is_fundamental<detail::remove_cvref_t<decltype(item)>>::value) {
+      detail::add_serialized_size(item, sa);
+    } else {
+      detail::add_serialized_size_with_size(item, sa);
+    }
+    if (!sa.known) break;
+  }
+  return sa;
+}
+
+template <typename T,
+          typename std::enable_if<detail::is_std_list_like<T>::value && !detail::is_raw_std_vector<T>::value && !detail::is_pod_std_vector<T>::value,
+                                  int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   detail::auto_size size;
   size << ia;
+  // each item takes at least one byte
+  if (!ia.require(size.value)) return ia;
   for (size_t i = 0; i < size.value; ++i) {
     typename T::value_type item;
     if (std::is_fundamental<detail::remove_cvref_t<decltype(item)>>::value) {
       item << ia;
+      if (ia.error) break;
     } else {
       serialize_iarchive tmp;
       tmp << ia;
+      if (ia.error) break;
       item << tmp;
       if (tmp.error) {
         ia.error = true;
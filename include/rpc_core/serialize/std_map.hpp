@@ -29,21 +29,32 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   detail::auto_size size(t.size());
   size >> oa;
   for (auto& item : t) {
-    serialize_oarchive tmp;
-    item >> tmp;
-    tmp >> oa;
+    detail::serialize_with_size(item, oa);
   }
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_map_like<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::auto_size(t.size()) >> sa;
+  for (auto& item : t) {
+    detail::add_serialized_size_with_size(item, sa);
+    if (!sa.known) break;
+  }
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_map_like<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   detail::auto_size size;
   size << ia;
+  // each item takes at least one byte
+  if (!ia.require(size.value)) return ia;
   for (size_t i = 0; i < size.value; ++i) {
     typename T::value_type item;
     serialize_iarchive tmp;
     tmp << ia;
+    if (ia.error) break;
     item << tmp;
     if (tmp.error) {
       ia.error = true;
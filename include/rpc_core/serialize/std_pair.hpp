@@ -20,6 +20,12 @@ inline serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_pair<T>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  std::tie(t.first, t.second) >> sa;
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_pair<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   using first_type = detail::remove_cvref_t<decltype(t.first)>;
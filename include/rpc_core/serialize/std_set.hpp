@@ -32,25 +32,41 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
     if (std::is_fundamental<detail::remove_cvref_t<decltype(item)>>::value) {
       item >> oa;
     } else {
-      serialize_oarchive tmp;
-      item >> tmp;
-      tmp >> oa;
+      detail::serialize_with_size(item, oa);
     }
   }
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_set_like<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::auto_size(t.size()) >> sa;
+  for (auto& item : t) {
+    if (std::is_fundamental<detail::remove_cvref_t<decltype(item)>>::value) {
+      detail::add_serialized_size(item, sa);
+    } else {
+      detail::add_serialized_size_with_size(item, sa);
+    }
+    if (!sa.known) break;
+  }
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_set_like<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   detail::auto_size size;
   size << ia;
+  // each item takes at least one byte
+  if (!ia.require(size.value)) return ia;
   for (size_t i = 0; i < size.value; ++i) {
     typename T::value_type item;
     if (std::is_fundamental<detail::remove_cvref_t<decltype(item)>>::value) {
       item << ia;
+      if (ia.error) break;
     } else {
       serialize_iarchive tmp;
       tmp << ia;
+      if (ia.error) break;
       item << tmp;
       if (tmp.error) {
         ia.error = true;
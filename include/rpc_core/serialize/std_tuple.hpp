@@ -41,9 +41,7 @@ struct tuple_serialize_helper_impl;
 template <typename Tuple, std::size_t I>
 struct tuple_serialize_helper_impl<Tuple, I, tuple_serialize_type::Normal> {
   static void serialize(const Tuple& t, serialize_oarchive& oa) {
-    serialize_oarchive tmp;
-    std::get<I>(t) >> tmp;
-    tmp >> oa;
+    detail::serialize_with_size(std::get<I>(t), oa);
   }
 };
 
@@ -82,6 +80,46 @@ void tuple_serialize(const std::tuple<Args...>& t, serialize_oarchive& oa) {
   tuple_serialize_helper<decltype(t), sizeof...(Args)>::serialize(t, oa);
 }
 
+template <typename Tuple, std::size_t I, tuple_serialize_type type>
+struct tuple_size_helper_impl;
+
+template <typename Tuple, std::size_t I>
+struct tuple_size_helper_impl<Tuple, I, tuple_serialize_type::Normal> {
+  static void size(const Tuple& t, serialize_size_archive& sa) {
+    add_serialized_size_with_size(std::get<I>(t), sa);
+  }
+};
+
+template <typename Tuple, std::size_t I>
+struct tuple_size_helper_impl<Tuple, I, tuple_serialize_type::RawType> {
+  static void size(const Tuple& t, serialize_size_archive& sa) {
+    add_serialized_size(std::get<I>(t), sa);
+  }
+};
+
+template <typename Tuple, std::size_t I>
+struct tuple_size_helper_impl<Tuple, I, tuple_serialize_type::Ignore> {
+  static void size(const Tuple& t, serialize_size_archive& sa) {
+    RPC_CORE_UNUSED(t);
+    RPC_CORE_UNUSED(sa);
+  }
+};
+
+template <typename Tuple, std::size_t N>
+struct tuple_size_helper {
+  static void size(const Tuple& t, serialize_size_archive& sa) {
+    tuple_size_helper<Tuple, N - 1>::size(t, sa);
+    tuple_size_helper_impl<Tuple, N - 1, tuple_serialize_type_check<tuple_element_t<N - 1, Tuple>>::value>::size(t, sa);
+  }
+};
+
+template <typename Tuple>
+struct tuple_size_helper<Tuple, 1> {
+  static void size(const Tuple& t, serialize_size_archive& sa) {
+    tuple_size_helper_impl<Tuple, 0, tuple_serialize_type_check<tuple_element_t<0, Tuple>>::value>::size(t, sa);
+  }
+};
+
 template <typename Tuple, std::size_t I, tuple_serialize_type type>
 struct tuple_de_serialize_helper_impl;
 
@@ -90,7 +128,9 @@ struct tuple_de_serialize_helper_impl<Tuple, I, tuple_serialize_type::Normal> {
   static void de_serialize(Tuple& t, serialize_iarchive& ia) {
     serialize_iarchive tmp;
     tmp << ia;
+    if (ia.error) return;
     std::get<I>(t) << tmp;
+    ia.error = tmp.error;
   }
 };
 
@@ -138,6 +178,12 @@ serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_tuple<T>::value, int>::type = 0>
+serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::tuple_size_helper<T, std::tuple_size<T>::value>::size(t, sa);
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_tuple<T>::value, int>::type = 0>
 serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   detail::tuple_de_serialize(t, ia);
@@ -25,11 +25,20 @@ inline serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_std_unique_ptr<T>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  true >> sa;
+  if (t != nullptr) {
+    detail::add_serialized_size(*t, sa);
+  }
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_std_unique_ptr<T>::value, int>::type = 0>
 inline serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   bool notnull;
   notnull << ia;
-  if (notnull) {
+  if (notnull && !ia.error) {
     using Type = typename T::element_type;
     t = std::unique_ptr<Type>(new Type);
     *t << ia;
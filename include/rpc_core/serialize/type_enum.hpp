@@ -9,6 +9,12 @@ inline serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  detail::auto_uintmax((uintmax_t)t) >> sa;
+  return sa;
+}
+
 template <typename T, typename std::enable_if<std::is_enum<T>::value, int>::type = 0>
 inline serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   detail::auto_uintmax impl;
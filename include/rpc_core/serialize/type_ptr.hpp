@@ -11,6 +11,12 @@ inline serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
   return oa;
 }
 
+template <typename T, typename std::enable_if<std::is_pointer<T>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  (intptr_t)t >> sa;
+  return sa;
+}
+
 template <typename T, typename std::enable_if<std::is_pointer<T>::value, int>::type = 0>
 inline serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
   intptr_t ptr;
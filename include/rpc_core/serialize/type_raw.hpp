@@ -1,40 +1,71 @@
 #pragma once
 
 #include <cstring>
+#include <initializer_list>
 #include <type_traits>
 
 #include "detail/auto_size.hpp"
 
-#define RPC_CORE_DETAIL_DEFINE_RAW_TYPE(type_raw, type_size)                         \
-  static_assert(sizeof(type_raw) <= type_size, "");                                  \
-  inline serialize_oarchive& operator>>(const type_raw& t, serialize_oarchive& oa) { \
-    oa.data.append((char*)&t, type_size);                                            \
-    return oa;                                                                       \
-  }                                                                                  \
-  inline serialize_iarchive& operator<<(type_raw& t, serialize_iarchive& ia) {       \
-    t = {};                                                                          \
-    memcpy(&t, ia.data, detail::min<size_t>(sizeof(t), type_size));                  \
-    ia.data += type_size;                                                            \
-    ia.size -= type_size;                                                            \
-    return ia;                                                                       \
+#define RPC_CORE_DETAIL_DEFINE_RAW_TYPE(type_raw, type_size)                                      \
+  static_assert(sizeof(type_raw) <= type_size, "");                                               \
+  inline serialize_oarchive& operator>>(const type_raw& t, serialize_oarchive& oa) {              \
+    oa.data.append((char*)&t, type_size);                                                         \
+    return oa;                                                                                    \
+  }                                                                                               \
+  /* template: no implicit conversion, e.g. from pointer to bool */                               \
+  template <typename T, typename std::enable_if<std::is_same<T, type_raw>::value, int>::type = 0> \
+  inline serialize_size_archive& operator>>(const T&, serialize_size_archive& sa) {               \
+    sa.size += type_size;                                                                         \
+    return sa;                                                                                    \
+  }                                                                                               \
+  inline serialize_iarchive& operator<<(type_raw& t, serialize_iarchive& ia) {                    \
+    t = {};                                                                                       \
+    if (!ia.require(type_size)) return ia;                                                        \
+    memcpy(&t, ia.data, detail::min<size_t>(sizeof(t), type_size));                               \
+    ia.advance(type_size);                                                                        \
+    return ia;                                                                                    \
   }
 
-#define RPC_CORE_DETAIL_DEFINE_RAW_TYPE_AUTO_SIZE(type_raw, type_auto)               \
-  inline serialize_oarchive& operator>>(const type_raw& t, serialize_oarchive& oa) { \
-    type_auto impl(t);                                                               \
-    impl >> oa;                                                                      \
-    return oa;                                                                       \
-  }                                                                                  \
-  inline serialize_iarchive& operator<<(type_raw& t, serialize_iarchive& ia) {       \
-    type_auto impl;                                                                  \
-    impl << ia;                                                                      \
-    t = (type_raw)impl.value;                                                        \
-    return ia;                                                                       \
+#define RPC_CORE_DETAIL_DEFINE_RAW_TYPE_AUTO_SIZE(type_raw, type_auto)                            \
+  inline serialize_oarchive& operator>>(const type_raw& t, serialize_oarchive& oa) {              \
+    type_auto impl(t);                                                                            \
+    impl >> oa;                                                                                   \
+    return oa;                                                                                    \
+  }                                                                                               \
+  template <typename T, typename std::enable_if<std::is_same<T, type_raw>::value, int>::type = 0> \
+  inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {             \
+    sa.size += type_auto(t).serialized_size();                                                    \
+    return sa;                                                                                    \
+  }                                                                                               \
+  inline serialize_iarchive& operator<<(type_raw& t, serialize_iarchive& ia) {                    \
+    type_auto impl;                                                                               \
+    impl << ia;                                                                                   \
+    t = (type_raw)impl.value;                                                                     \
+    return ia;                                                                                    \
   }
 
 namespace rpc_core {
 
-RPC_CORE_DETAIL_DEFINE_RAW_TYPE(bool, 1);
+inline serialize_oarchive& operator>>(const bool& t, serialize_oarchive& oa) {
+  oa.data.push_back((char)t);
+  return oa;
+}
+
+template <typename T, typename std::enable_if<std::is_same<T, bool>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T&, serialize_size_archive& sa) {
+  sa.size += 1;
+  return sa;
+}
+
+inline serialize_iarchive& operator<<(bool& t, serialize_iarchive& ia) {
+  t = false;
+  if (!ia.require(1)) return ia;
+  // not memcpy: a byte other than 0/1 is not a valid bool
+  t = *ia.data != 0;
+  ia.advance(1);
+  return ia;
+}
+
 RPC_CORE_DETAIL_DEFINE_RAW_TYPE(char, 1);
 RPC_CORE_DETAIL_DEFINE_RAW_TYPE(signed char, 1);
 RPC_CORE_DETAIL_DEFINE_RAW_TYPE(unsigned char, 1);
@@ -51,4 +82,116 @@ RPC_CORE_DETAIL_DEFINE_RAW_TYPE(float, 4);
 RPC_CORE_DETAIL_DEFINE_RAW_TYPE(double, 8);
 RPC_CORE_DETAIL_DEFINE_RAW_TYPE(long double, 16);
 
+namespace detail {
+
+/**
+ * Types serialized as their memory bytes, contiguous arrays of them can be copied in bulk.
+ * bool is excluded since not every byte is a valid bool.
+ */
+template <typename T>
+struct is_raw_wire_type : std::false_type {};
+
+#define RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(type_raw, type_size)                                     \
+  template <>                                                                                         \
+  struct is_raw_wire_type<type_raw> : std::integral_constant<bool, sizeof(type_raw) == type_size> {};
+
+RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(char, 1);
+RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(signed char, 1);
+RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(unsigned char, 1);
+RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(short, 2);
+RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(unsigned short, 2);
+RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(float, 4);
+RPC_CORE_DETAIL_DEFINE_RAW_WIRE_TYPE(double, 8);
+
+/**
+ * write/read count items of raw wire type with one memcpy
+ */
+template <typename T>
+inline void serialize_raw_array(const T* data, size_t count, serialize_oarchive& oa) {
+  oa.data.append((const char*)data, count * sizeof(T));
+}
+
+template <typename T>
+inline bool deserialize_raw_array(T* data, size_t count, serialize_iarchive& ia) {
+  if (ia.error || count > ia.size / sizeof(T)) {
+    ia.error = true;
+    return false;
+  }
+  const size_t bytes = count * sizeof(T);
+  memcpy(data, ia.data, bytes);
+  ia.advance(bytes);
+  return true;
+}
+
+/**
+ * field of RPC_CORE_DEFINE_TYPE, for compile time layout check
+ */
+struct pod_field {
+  bool raw;
+  size_t offset;
+  size_t size;
+};
+
+/**
+ * true if the fields are all raw wire types and tile the struct in listed order without padding,
+ * so the memory of the struct is the same as its serialized fields.
+ * fields[0] is a placeholder.
+ */
+template <typename T>
+constexpr bool pod_on_wire_layout(std::initializer_list<pod_field> fields) {
+  if (!std::is_standard_layout<T>::value || !std::is_trivially_copyable<T>::value) return false;
+  size_t offset = 0;
+  for (auto it = fields.begin() + 1; it != fields.end(); ++it) {
+    if (!it->raw || it->offset != offset) return false;
+    offset += it->size;
+  }
+  return offset == sizeof(T);
+}
+
+/**
+ * RPC_CORE_DEFINE_TYPE defines an overload for its type, found by ADL
+ */
+constexpr bool rpc_core_detail_pod_on_wire(const void*) {
+  return false;
+}
+
+template <typename T>
+struct pod_on_wire_impl : std::integral_constant<bool, rpc_core_detail_pod_on_wire((const T*)nullptr)> {};
+
+}  // namespace detail
+
+/**
+ * Struct defined by RPC_CORE_DEFINE_TYPE is serialized by one memcpy when it is pod on wire:
+ * all fields are raw wire types(char, short, float, double...), listed in declaration order, without padding.
+ * Notice: int/long fields are variable length on wire, use int16_t/float/double or not pod.
+ */
+template <typename T>
+struct is_pod_on_wire : detail::pod_on_wire_impl<T> {};
+
+namespace detail {
+
+template <typename T, typename std::enable_if<!is_pod_on_wire<T>::value, int>::type = 0>
+inline bool serialize_pod(const T&, serialize_oarchive&) {
+  return false;
+}
+
+template <typename T, typename std::enable_if<is_pod_on_wire<T>::value, int>::type = 0>
+inline bool serialize_pod(const T& t, serialize_oarchive& oa) {
+  serialize_raw_array(&t, 1, oa);
+  return true;
+}
+
+template <typename T, typename std::enable_if<!is_pod_on_wire<T>::value, int>::type = 0>
+inline bool deserialize_pod(T&, serialize_iarchive&) {
+  return false;
+}
+
+template <typename T, typename std::enable_if<is_pod_on_wire<T>::value, int>::type = 0>
+inline bool deserialize_pod(T& t, serialize_iarchive& ia) {
+  deserialize_raw_array(&t, 1, ia);
+  return true;
+}
+
+}  // namespace detail
+
 }  // namespace rpc_core
@@ -133,13 +133,25 @@
 
 #define RPC_CORE_DETAIL_SERIALIZE_FIELD(v1) ar & t.v1;
 #define RPC_CORE_DETAIL_SERIALIZE_FIELD_INNER(v1) ar & this->v1;
+#define RPC_CORE_DETAIL_SERIALIZE_POD_FIELD(v1) , ::rpc_core::detail::pod_field{::rpc_core::detail::is_raw_wire_type<decltype(T::v1)>::value, offsetof(T, v1), sizeof(T::v1)}
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD(tag_v1) RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD_IMPL tag_v1
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD_IMPL(tag, v1) ::rpc_core::detail::tagged_write(tag, t.v1, ar);
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD_INNER(tag_v1) RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD_INNER_IMPL tag_v1
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD_INNER_IMPL(tag, v1) ::rpc_core::detail::tagged_write(tag, this->v1, ar);
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE(tag_v1) RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE_IMPL tag_v1
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE_IMPL(tag, v1) case tag: ::rpc_core::detail::tagged_read(wire, t.v1, ar); break;
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE_INNER(tag_v1) RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE_INNER_IMPL tag_v1
+#define RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE_INNER_IMPL(tag, v1) case tag: ::rpc_core::detail::tagged_read(wire, this->v1, ar); break;
 // clang-format on
 
 #include <string>
 #include <type_traits>
 
+#include <cstddef>
+
 #include "../detail/noncopyable.hpp"
 #include "../detail/string_view.hpp"
+#include "../detail/varint.hpp"
 
 namespace rpc_core {
 
@@ -151,12 +163,22 @@ inline serialize_oarchive& operator&(serialize_oarchive& oa, const T& t) {
 
 template <typename T, typename std::enable_if<!std::is_fundamental<T>::value, int>::type = 0>
 inline serialize_oarchive& operator&(serialize_oarchive& oa, const T& t) {
-  serialize_oarchive tmp;
-  t >> tmp;
-  tmp >> oa;
+  detail::serialize_with_size(t, oa);
   return oa;
 }
 
+template <typename T, typename std::enable_if<std::is_fundamental<T>::value, int>::type = 0>
+inline serialize_size_archive& operator&(serialize_size_archive& sa, const T& t) {
+  detail::add_serialized_size(t, sa);
+  return sa;
+}
+
+template <typename T, typename std::enable_if<!std::is_fundamental<T>::value, int>::type = 0>
+inline serialize_size_archive& operator&(serialize_size_archive& sa, const T& t) {
+  detail::add_serialized_size_with_size(t, sa);
+  return sa;
+}
+
 template <typename T, typename std::enable_if<std::is_fundamental<T>::value, int>::type = 0>
 inline serialize_iarchive& operator&(serialize_iarchive& ia, T& t) {
   if (ia.error) return ia;
@@ -167,27 +189,166 @@ inline serialize_iarchive& operator&(serialize_iarchive& ia, T& t) {
 template <typename T, typename std::enable_if<!std::is_fundamental<T>::value, int>::type = 0>
 serialize_iarchive& operator&(serialize_iarchive& ia, T& t) {
   if (ia.error) return ia;
-  detail::auto_size auto_size;
-  int cost = auto_size.deserialize(ia.data);
-  auto size = auto_size.value;
-  ia.data += cost;
-
-  serialize_iarchive tmp(detail::string_view(ia.data, size));
+  serialize_iarchive tmp;
+  tmp << ia;
+  if (ia.error) return ia;
   t << tmp;
   ia.error = tmp.error;
-
-  ia.data += size;
   return ia;
 }
 
+namespace detail {
+
+/**
+ * Wire type of tagged field, tells how to skip an unknown field.
+ * fixed: 1 << wire bytes, auto: auto_size encoded integer, length: auto_size length prefixed
+ */
+enum tagged_wire : uint8_t {
+  tagged_fixed1 = 0,
+  tagged_fixed2 = 1,
+  tagged_fixed4 = 2,
+  tagged_fixed8 = 3,
+  tagged_fixed16 = 4,
+  tagged_auto = 5,
+  tagged_length = 6,
+};
+
+template <typename T>
+struct tagged_wire_type : std::integral_constant<uint8_t, tagged_length> {};
+
+#define RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(type, wire) \
+  template <>                                               \
+  struct tagged_wire_type<type> : std::integral_constant<uint8_t, wire> {};
+
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(bool, tagged_fixed1);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(char, tagged_fixed1);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(signed char, tagged_fixed1);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(unsigned char, tagged_fixed1);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(short, tagged_fixed2);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(unsigned short, tagged_fixed2);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(float, tagged_fixed4);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(double, tagged_fixed8);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(long double, tagged_fixed16);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(int, tagged_auto);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(unsigned int, tagged_auto);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(long, tagged_auto);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(unsigned long, tagged_auto);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(long long, tagged_auto);
+RPC_CORE_DETAIL_DEFINE_TAGGED_WIRE_TYPE(unsigned long long, tagged_auto);
+
+/**
+ * field key: varint of (tag << 3 | wire type)
+ */
+template <typename T>
+inline uint8_t tagged_key(uint32_t tag, uint8_t* buf) {
+  static_assert(!std::is_fundamental<T>::value || tagged_wire_type<T>::value != tagged_length, "unsupported fundamental type");
+  return (uint8_t)(varint_encode(((uint64_t)tag << 3) | tagged_wire_type<T>::value, buf) - buf);
+}
+
+template <typename T>
+inline void tagged_write(uint32_t tag, const T& t, serialize_oarchive& oa) {
+  uint8_t buf[VarintMaxBytes];
+  oa.data.append((char*)buf, tagged_key<T>(tag, buf));
+  oa & t;
+}
+
+template <typename T>
+inline void tagged_write(uint32_t tag, const T& t, serialize_size_archive& sa) {
+  uint8_t buf[VarintMaxBytes];
+  sa.size += tagged_key<T>(tag, buf);
+  sa & t;
+}
+
+inline bool tagged_read_key(serialize_iarchive& ia, uint32_t& tag, uint8_t& wire) {
+  auto p = (const uint8_t*)ia.data;
+  uint64_t key;
+  auto end = varint_decode(p, p + ia.size, key);
+  if (end == nullptr || (key >> 3) > UINT32_MAX) {
+    ia.error = true;
+    return false;
+  }
+  ia.advance(end - p);
+  tag = (uint32_t)(key >> 3);
+  wire = (uint8_t)(key & 7);
+  return true;
+}
+
+template <typename T>
+inline void tagged_read(uint8_t wire, T& t, serialize_iarchive& ia) {
+  // changing the type of a field is not compatible
+  if (wire != tagged_wire_type<T>::value) {
+    ia.error = true;
+    return;
+  }
+  ia & t;
+}
+
+/**
+ * skip unknown field without decoding it
+ */
+inline void tagged_skip(uint8_t wire, serialize_iarchive& ia) {
+  size_t size;
+  switch (wire) {
+    case tagged_fixed1:
+    case tagged_fixed2:
+    case tagged_fixed4:
+    case tagged_fixed8:
+    case tagged_fixed16:
+      size = (size_t)1 << wire;
+      break;
+    case tagged_auto: {
+      if (!ia.require(1)) return;
+      const uint8_t bytes = *ia.data & 0x7f;
+      if (bytes > sizeof(uintmax_t)) {
+        ia.error = true;
+        return;
+      }
+      size = 1 + bytes;
+    } break;
+    case tagged_length: {
+      serialize_iarchive tmp;
+      tmp << ia;
+      return;
+    }
+    default:
+      ia.error = true;
+      return;
+  }
+  if (ia.require(size)) {
+    ia.advance(size);
+  }
+}
+
+}  // namespace detail
 }  // namespace rpc_core
 
-#define RPC_CORE_DEFINE_TYPE(Type, ...)                                           \
-  inline void operator>>(const Type& t, ::rpc_core::serialize_oarchive& ar) {     \
-    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD, __VA_ARGS__) \
-  }                                                                               \
-  inline void operator<<(Type& t, ::rpc_core::serialize_iarchive& ar) {           \
-    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD, __VA_ARGS__) \
+// offsetof of non-standard-layout type is checked by pod_on_wire_layout
+#if defined(__GNUC__) || defined(__clang__)
+#define RPC_CORE_DETAIL_OFFSETOF_BEGIN _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Winvalid-offsetof\"")
+#define RPC_CORE_DETAIL_OFFSETOF_END _Pragma("GCC diagnostic pop")
+#else
+#define RPC_CORE_DETAIL_OFFSETOF_BEGIN
+#define RPC_CORE_DETAIL_OFFSETOF_END
+#endif
+
+#define RPC_CORE_DEFINE_TYPE(Type, ...)                                                                                       \
+  RPC_CORE_DETAIL_OFFSETOF_BEGIN                                                                                              \
+  template <typename T, typename std::enable_if<std::is_same<T, Type>::value, int>::type = 0>                                 \
+  constexpr bool rpc_core_detail_pod_on_wire(const T*) {                                                                      \
+    return ::rpc_core::detail::pod_on_wire_layout<T>(                                                                         \
+        {::rpc_core::detail::pod_field{} RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_POD_FIELD, __VA_ARGS__)}); \
+  }                                                                                                                           \
+  RPC_CORE_DETAIL_OFFSETOF_END                                                                                                \
+  inline void operator>>(const Type& t, ::rpc_core::serialize_oarchive& ar) {                                                 \
+    if (::rpc_core::detail::serialize_pod(t, ar)) return;                                                                     \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD, __VA_ARGS__)                                             \
+  }                                                                                                                           \
+  inline void operator>>(const Type& t, ::rpc_core::serialize_size_archive& ar) {                                             \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD, __VA_ARGS__)                                             \
+  }                                                                                                                           \
+  inline void operator<<(Type& t, ::rpc_core::serialize_iarchive& ar) {                                                       \
+    if (::rpc_core::detail::deserialize_pod(t, ar)) return;                                                                   \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD, __VA_ARGS__)                                             \
   }
 
 #define RPC_CORE_DEFINE_TYPE_INNER(...)                                                 \
@@ -195,6 +356,54 @@ serialize_iarchive& operator&(serialize_iarchive& ia, T& t) {
   void operator>>(::rpc_core::serialize_oarchive& ar) const {                           \
     RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD_INNER, __VA_ARGS__) \
   }                                                                                     \
+  void operator>>(::rpc_core::serialize_size_archive& ar) const {                       \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD_INNER, __VA_ARGS__) \
+  }                                                                                     \
   void operator<<(::rpc_core::serialize_iarchive& ar) {                                 \
     RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_FIELD_INNER, __VA_ARGS__) \
   }
+
+/**
+ * Tagged fields: RPC_CORE_DEFINE_TYPE_TAGGED(Type, (1, field_a), (2, field_b))
+ * Each field is written with its tag and wire type, so fields can be added, removed or reordered, unknown fields are
+ * skipped and missing fields keep their value. Tags should be unique and never reused, field type should not change.
+ * Costs one or more key bytes per field, RPC_CORE_DEFINE_TYPE is smaller and faster when peers upgrade together.
+ */
+#define RPC_CORE_DEFINE_TYPE_TAGGED(Type, ...)                                               \
+  inline void operator>>(const Type& t, ::rpc_core::serialize_oarchive& ar) {                \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD, __VA_ARGS__)     \
+  }                                                                                          \
+  inline void operator>>(const Type& t, ::rpc_core::serialize_size_archive& ar) {            \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD, __VA_ARGS__)     \
+  }                                                                                          \
+  inline void operator<<(Type& t, ::rpc_core::serialize_iarchive& ar) {                      \
+    uint32_t tag;                                                                            \
+    uint8_t wire;                                                                            \
+    while (!ar.error && ar.size > 0 && ::rpc_core::detail::tagged_read_key(ar, tag, wire)) { \
+      switch (tag) {                                                                         \
+        RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE, __VA_ARGS__)  \
+        default:                                                                             \
+          ::rpc_core::detail::tagged_skip(wire, ar);                                         \
+      }                                                                                      \
+    }                                                                                        \
+  }
+
+#define RPC_CORE_DEFINE_TYPE_TAGGED_INNER(...)                                                    \
+ public:                                                                                          \
+  void operator>>(::rpc_core::serialize_oarchive& ar) const {                                     \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD_INNER, __VA_ARGS__)    \
+  }                                                                                               \
+  void operator>>(::rpc_core::serialize_size_archive& ar) const {                                 \
+    RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_TAGGED_FIELD_INNER, __VA_ARGS__)    \
+  }                                                                                               \
+  void operator<<(::rpc_core::serialize_iarchive& ar) {                                           \
+    uint32_t tag;                                                                                 \
+    uint8_t wire;                                                                                 \
+    while (!ar.error && ar.size > 0 && ::rpc_core::detail::tagged_read_key(ar, tag, wire)) {      \
+      switch (tag) {                                                                              \
+        RPC_CORE_DETAIL_SERIALIZE_PASTE(RPC_CORE_DETAIL_SERIALIZE_TAGGED_CASE_INNER, __VA_ARGS__) \
+        default:                                                                                  \
+          ::rpc_core::detail::tagged_skip(wire, ar);                                              \
+      }                                                                                           \
+    }                                                                                             \
+  }
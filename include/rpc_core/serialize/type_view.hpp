@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../detail/string_view.hpp"
+
+namespace rpc_core {
+
+/**
+ * Non-owning view of a serialized std::vector<T>/std::array<T, N>, T should be raw wire type(char, short, float, double...).
+ * Deserialized view points into the received package without copy, so it is only valid during the handler call.
+ * The package is not aligned, items are read by memcpy.
+ */
+template <typename T>
+class array_view {
+  static_assert(detail::is_raw_wire_type<T>::value, "T should be raw wire type");
+
+ public:
+  array_view() = default;
+  array_view(const T* data, size_t size) : data_((const char*)data), size_(size) {}
+  explicit array_view(const std::vector<T>& data) : array_view(data.data(), data.size()) {}
+
+  size_t size() const {
+    return size_;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  T operator[](size_t i) const {
+    T value;
+    memcpy(&value, data_ + i * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  const char* bytes() const {
+    return data_;
+  }
+
+  size_t bytes_size() const {
+    return size_ * sizeof(T);
+  }
+
+  std::vector<T> to_vector() const {
+    std::vector<T> ret(size_);
+    memcpy(ret.data(), data_, bytes_size());
+    return ret;
+  }
+
+ private:
+  template <typename U>
+  friend serialize_iarchive& operator<<(array_view<U>& t, serialize_iarchive& ia);
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/// detail::string_view: same as std::string on wire, deserialize without copy
+// template: no implicit conversion from std::string
+template <typename T, typename std::enable_if<std::is_same<T, detail::string_view>::value, int>::type = 0>
+inline serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
+  oa.data.append(t.data(), t.size());
+  return oa;
+}
+
+template <typename T, typename std::enable_if<std::is_same<T, detail::string_view>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  sa.size += t.size();
+  return sa;
+}
+
+template <typename T, typename std::enable_if<std::is_same<T, detail::string_view>::value, int>::type = 0>
+inline serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
+  if (ia.error) return ia;
+  // takes all remaining bytes like std::string
+  t = detail::string_view(ia.data, ia.size);
+  ia.advance(ia.size);
+  return ia;
+}
+
+/// array_view: same as std::vector<T> on wire
+template <typename T>
+inline serialize_oarchive& operator>>(const array_view<T>& t, serialize_oarchive& oa) {
+  detail::auto_size(t.size()) >> oa;
+  oa.data.append(t.bytes(), t.bytes_size());
+  return oa;
+}
+
+template <typename T>
+inline serialize_size_archive& operator>>(const array_view<T>& t, serialize_size_archive& sa) {
+  detail::auto_size(t.size()) >> sa;
+  sa.size += t.bytes_size();
+  return sa;
+}
+
+namespace detail {
+
+/**
+ * true for view types, and std::pair/std::tuple containing them, they should not outlive the handler call
+ */
+template <typename T>
+struct is_view_type : std::false_type {};
+
+template <>
+struct is_view_type<string_view> : std::true_type {};
+
+template <typename T>
+struct is_view_type<array_view<T>> : std::true_type {};
+
+template <typename T1, typename T2>
+struct is_view_type<std::pair<T1, T2>> : std::integral_constant<bool, is_view_type<T1>::value || is_view_type<T2>::value> {};
+
+template <>
+struct is_view_type<std::tuple<>> : std::false_type {};
+
+template <typename T, typename... Args>
+struct is_view_type<std::tuple<T, Args...>> : std::integral_constant<bool, is_view_type<T>::value || is_view_type<std::tuple<Args...>>::value> {};
+
+}  // namespace detail
+
+template <typename T>
+serialize_iarchive& operator<<(array_view<T>& t, serialize_iarchive& ia) {
+  detail::auto_size size;
+  size << ia;
+  if (ia.error || size.value > ia.size / sizeof(T)) {
+    ia.error = true;
+    return ia;
+  }
+  t.data_ = ia.data;
+  t.size_ = size.value;
+  ia.advance(t.bytes_size());
+  return ia;
+}
+
+}  // namespace rpc_core
@@ -11,6 +11,14 @@ namespace rpc_core {
 template <typename T>
 inline std::string serialize(T&& t) {
   serialize_oarchive ar;
+  // rvalue string is moved into the archive
+  if (!std::is_same<T, std::string>::value) {
+    serialize_size_archive sa;
+    detail::add_serialized_size(t, sa);
+    if (sa.known) {
+      ar.data.reserve(sa.size);
+    }
+  }
   std::forward<T>(t) >> ar;
   return std::move(ar.data);
 }
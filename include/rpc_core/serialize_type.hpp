@@ -16,7 +16,8 @@ struct serialize_oarchive : detail::noncopyable {
 };
 
 inline serialize_oarchive& operator>>(const serialize_oarchive& t, serialize_oarchive& oa) {
-  oa.data.append(detail::auto_size(t.data.size()).serialize());
+  char size[detail::auto_size::MaxBytes];
+  oa.data.append(size, detail::auto_size(t.data.size()).serialize(size));
   oa.data.append(t.data);
   return oa;
 }
@@ -26,15 +27,111 @@ inline serialize_oarchive& operator>>(serialize_oarchive&& t, serialize_oarchive
     oa.data = std::move(t.data);
     return oa;
   }
-  oa.data.append(detail::auto_size(t.data.size()).serialize());
+  char size[detail::auto_size::MaxBytes];
+  oa.data.append(size, detail::auto_size(t.data.size()).serialize(size));
   oa.data.append(t.data);
   return oa;
 }
 
+/**
+ * Computes serialized size without writing, so serialize() can reserve once.
+ * Types without `operator>>(const T&, serialize_size_archive&)` make the size unknown.
+ */
+struct serialize_size_archive : detail::noncopyable {
+  size_t size = 0;
+  bool known = true;
+};
+
+namespace detail {
+
+template <typename...>
+struct make_void {
+  using type = void;
+};
+
+template <typename T, typename = void>
+struct has_serialized_size : std::false_type {};
+
+template <typename T>
+struct has_serialized_size<T, typename make_void<decltype(std::declval<const T&>() >> std::declval<serialize_size_archive&>())>::type>
+    : std::true_type {};
+
+template <typename T, typename std::enable_if<has_serialized_size<T>::value, int>::type = 0>
+inline void add_serialized_size(const T& t, serialize_size_archive& sa) {
+  t >> sa;
+}
+
+template <typename T, typename std::enable_if<!has_serialized_size<T>::value, int>::type = 0>
+inline void add_serialized_size(const T&, serialize_size_archive& sa) {
+  sa.known = false;
+}
+
+/**
+ * size of t with auto_size prefix, see serialize_with_size
+ */
+template <typename T>
+inline void add_serialized_size_with_size(const T& t, serialize_size_archive& sa) {
+  if (!sa.known) return;
+  serialize_size_archive item;
+  add_serialized_size(t, item);
+  sa.known = item.known;
+  sa.size += auto_size(item.size).serialized_size() + item.size;
+}
+
+/**
+ * Write t with auto_size prefix in place, same as serializing t into a temporary archive and appending it,
+ * without the temporary allocation and copy.
+ * The prefix is written first if the size of t is known, otherwise SizeGuess bytes are reserved for it,
+ * which fits size < 256, and the body is shifted if the prefix differs.
+ */
+template <typename T>
+inline void serialize_with_size(const T& t, serialize_oarchive& oa) {
+  serialize_size_archive sa;
+  add_serialized_size(t, sa);
+  char prefix[auto_size::MaxBytes];
+  if (sa.known) {
+    oa.data.append(prefix, auto_size(sa.size).serialize(prefix));
+    t >> oa;
+    return;
+  }
+  static const size_t SizeGuess = 2;
+  const size_t pos = oa.data.size();
+  oa.data.append(SizeGuess, '\0');
+  t >> oa;
+  const size_t size = oa.data.size() - pos - SizeGuess;
+  const size_t prefix_bytes = auto_size(size).serialize(prefix);
+  if (prefix_bytes > SizeGuess) {
+    oa.data.insert(pos, prefix_bytes - SizeGuess, '\0');
+  } else if (prefix_bytes < SizeGuess) {
+    oa.data.erase(pos, SizeGuess - prefix_bytes);
+  }
+  memcpy(&oa.data[pos], prefix, prefix_bytes);
+}
+
+}  // namespace detail
+
 struct serialize_iarchive : detail::noncopyable {
   serialize_iarchive() = default;
   explicit serialize_iarchive(const detail::string_view& sv) : data(sv.data()), size(sv.size()) {}
   serialize_iarchive(const char* data, size_t size) : data(data), size(size) {}
+  /**
+   * Check n bytes are readable before reading, set error if not.
+   * Containers check their item count once, each item takes at least one byte.
+   */
+  inline bool require(size_t n) {
+    if (error || n > size) {
+      error = true;
+      return false;
+    }
+    return true;
+  }
+
+  inline void advance(size_t n) {
+    data += n;
+    size -= n;
+  }
+
+  // read cursor and remaining bytes
   const char* data = nullptr;
   size_t size = 0;
   bool error = false;
@@ -42,26 +139,41 @@ struct serialize_iarchive : detail::noncopyable {
 
 inline serialize_iarchive& operator<<(serialize_iarchive& t, serialize_iarchive& ia) {
   detail::auto_size size;
-  int cost = size.deserialize(ia.data);
-  ia.data += cost;
+  int cost = ia.error ? 0 : size.deserialize(ia.data, ia.size);
+  if (cost == 0 || size.value > ia.size - cost) {
+    ia.error = true;
+    t.error = true;
+    return ia;
+  }
+  ia.advance(cost);
   t.data = ia.data;
   t.size = size.value;
-  ia.data += size.value;
-  ia.size -= cost + size.value;
+  t.error = false;
+  ia.advance(size.value);
   return ia;
 }
 
 template <typename T, typename std::enable_if<detail::is_auto_size_type<T>::value, int>::type = 0>
 inline serialize_oarchive& operator>>(const T& t, serialize_oarchive& oa) {
-  oa.data.append(t.serialize());
+  char buf[T::MaxBytes];
+  oa.data.append(buf, t.serialize(buf));
   return oa;
 }
 
+template <typename T, typename std::enable_if<detail::is_auto_size_type<T>::value, int>::type = 0>
+inline serialize_size_archive& operator>>(const T& t, serialize_size_archive& sa) {
+  sa.size += t.serialized_size();
+  return sa;
+}
+
 template <typename T, typename std::enable_if<detail::is_auto_size_type<T>::value, int>::type = 0>
 inline serialize_iarchive& operator<<(T& t, serialize_iarchive& ia) {
-  int cost = t.deserialize((uint8_t*)ia.data);
-  ia.data += cost;
-  ia.size -= cost;
+  int cost = ia.error ? 0 : t.deserialize(ia.data, ia.size);
+  if (cost == 0) {
+    ia.error = true;
+    return ia;
+  }
+  ia.advance(cost);
   return ia;
 }
 
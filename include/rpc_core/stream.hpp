@@ -0,0 +1,197 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+// config
+#include "config.hpp"
+
+// include
+#include "detail/noncopyable.hpp"
+#include "request.hpp"
+#include "rpc.hpp"
+#include "serialize.hpp"
+
+namespace rpc_core {
+
+/**
+ * One chunk of a stream, sent as the msg of a normal request, the response is bool accepted.
+ */
+struct stream_chunk {
+  uint32_t id = 0;
+  uint32_t index = 0;
+  bool end = false;
+  /**
+   * set on the end chunk when the sender stops before the last chunk, data is empty and no response is needed
+   */
+  bool abort = false;
+  std::string data;
+};
+RPC_CORE_DEFINE_TYPE(stream_chunk, id, index, end, abort, data);
+
+/**
+ * Send large data as a sequence of chunks, at most `window` chunks wait for ack at the same time,
+ * so memory is bounded by chunk size * window on both sides.
+ * It holds rpc weakly, and finishes with rpc_expired if rpc is destroyed.
+ */
+class stream_sender : detail::noncopyable, public std::enable_shared_from_this<stream_sender> {
+ public:
+  /**
+   * fill next chunk into data, return false if it is the last chunk
+   */
+  using producer = std::function<bool(std::string& data)>;
+  using finally = std::function<void(finally_t)>;
+
+  static std::shared_ptr<stream_sender> create(rpc_w rpc, cmd_type cmd, producer producer, uint32_t window = 4) {
+    struct helper : public stream_sender {
+      helper(rpc_w r, cmd_type c, stream_sender::producer p, uint32_t w) : stream_sender(std::move(r), std::move(c), std::move(p), w) {}
+    };
+    return std::make_shared<helper>(std::move(rpc), std::move(cmd), std::move(producer), window);
+  }
+
+ private:
+  stream_sender(rpc_w rpc, cmd_type cmd, producer producer, uint32_t window)
+      : rpc_(std::move(rpc)), cmd_(std::move(cmd)), producer_(std::move(producer)), window_(window ? window : 1) {}
+
+ public:
+  std::shared_ptr<stream_sender> timeout_ms(uint32_t timeout_ms) {
+    timeout_ms_ = timeout_ms;
+    return shared_from_this();
+  }
+
+  /**
+   * called once: normal when all chunks are accepted, canceled if receiver rejected or cancel() called,
+   * an abort chunk is sent to the receiver if it is not normal
+   */
+  std::shared_ptr<stream_sender> on_finish(finally cb) {
+    finally_ = std::move(cb);
+    return shared_from_this();
+  }
+
+  void start() {
+    auto rpc = rpc_.lock();
+    if (!rpc) {
+      finish(finally_t::rpc_expired);
+      return;
+    }
+    id_ = rpc->make_seq();
+    started_ = true;
+    pump();
+  }
+
+  void cancel() {
+    finish(finally_t::canceled);
+  }
+
+  uint32_t sent_count() const {
+    return next_index_;
+  }
+
+ private:
+  void pump() {
+    if (pumping_) return;
+    auto rpc = rpc_.lock();
+    if (!rpc) {
+      finish(finally_t::rpc_expired);
+      return;
+    }
+    pumping_ = true;
+    while (!finished_ && !eof_ && inflight_ < window_) {
+      stream_chunk chunk;
+      chunk.id = id_;
+      chunk.index = next_index_++;
+      chunk.end = !producer_(chunk.data);
+      eof_ = chunk.end;
+      ++inflight_;
+      auto self = shared_from_this();
+      rpc->cmd(cmd_)
+          ->msg(chunk)
+          ->rsp([self](bool accepted) {
+            self->accepted_ = accepted;
+          })
+          ->finally([self](finally_t type) {
+            self->on_ack(type);
+          })
+          ->timeout_ms(timeout_ms_)
+          ->call();
+    }
+    pumping_ = false;
+  }
+
+  void on_ack(finally_t type) {
+    --inflight_;
+    if (type != finally_t::normal) {
+      finish(type);
+      return;
+    }
+    if (!accepted_) {
+      finish(finally_t::canceled);
+      return;
+    }
+    if (eof_ && inflight_ == 0) {
+      finish(finally_t::normal);
+      return;
+    }
+    pump();
+  }
+
+  void finish(finally_t type) {
+    if (finished_) return;
+    finished_ = true;
+    RPC_CORE_LOGD("stream:%u finish: %s", id_, finally_t_str(type));
+    if (type != finally_t::normal) {
+      send_abort();
+    }
+    if (finally_) {
+      finally_(type);
+    }
+  }
+
+  /**
+   * let the receiver release its state of the stream, it is after all sent chunks on the connection
+   */
+  void send_abort() {
+    if (!started_) return;
+    auto rpc = rpc_.lock();
+    if (!rpc) return;
+    stream_chunk chunk;
+    chunk.id = id_;
+    chunk.index = next_index_;
+    chunk.end = true;
+    chunk.abort = true;
+    rpc->cmd(cmd_)->msg(chunk)->call();
+  }
+
+ private:
+  rpc_w rpc_;
+  cmd_type cmd_;
+  producer producer_;
+  const uint32_t window_;
+  uint32_t timeout_ms_ = 3000;
+  finally finally_;
+  uint32_t id_ = 0;
+  uint32_t next_index_ = 0;
+  uint32_t inflight_ = 0;
+  bool accepted_ = false;
+  bool eof_ = false;
+  bool started_ = false;
+  bool finished_ = false;
+  bool pumping_ = false;
+};
+
+using stream_sender_s = std::shared_ptr<stream_sender>;
+
+/**
+ * Receive chunks of streams sent by stream_sender, consumer is called in order for each chunk,
+ * return false to reject, the sender will stop.
+ * The last chunk of a stream has end set, and abort set too if the sender stopped early, state of chunk.id can be released then.
+ */
+inline void subscribe_stream(const rpc_s& rpc, const cmd_type& cmd, std::function<bool(const stream_chunk& chunk)> consumer) {
+  rpc->subscribe(cmd, [consumer = std::move(consumer)](const stream_chunk& chunk) {
+    return consumer(chunk);
+  });
+}
+
+}  // namespace rpc_core
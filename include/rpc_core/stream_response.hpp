@@ -0,0 +1,259 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+// config
+#include "config.hpp"
+
+// include
+#include "connection.hpp"
+#include "detail/callable/callable.hpp"
+#include "detail/flat_table.hpp"
+#include "detail/msg_dispatcher.hpp"
+#include "detail/noncopyable.hpp"
+#include "serialize.hpp"
+
+namespace rpc_core {
+
+namespace detail {
+
+/**
+ * internal cmds sent by the stream receiver
+ * credit: std::pair<seq_type, uint32_t>, more items can be sent
+ * cancel: seq_type, stop the stream
+ */
+static const char* const StreamCreditCmd = "rpc_core.stream.credit";
+static const char* const StreamCancelCmd = "rpc_core.stream.cancel";
+
+/**
+ * payload of the end response when the stream is dropped without end, normal end has empty payload
+ */
+static const char* const StreamAbortPayload = "\x01";
+
+class stream_handler {
+ public:
+  virtual void add_credit(uint32_t credit) = 0;
+  virtual void peer_cancel() = 0;
+
+ protected:
+  ~stream_handler() = default;
+};
+
+/**
+ * streams being sent by this rpc, keyed by the seq of request
+ */
+struct stream_registry : noncopyable {
+  flat_table<std::weak_ptr<stream_handler>> streams;
+
+  struct any_entry {
+    bool operator()(const std::weak_ptr<stream_handler>&) const {
+      return true;
+    }
+  };
+
+  std::shared_ptr<stream_handler> find(seq_type seq) {
+    auto handler = streams.find(seq, any_entry());
+    return handler ? handler->lock() : nullptr;
+  }
+
+  void add(seq_type seq, std::weak_ptr<stream_handler> handler) {
+    streams.erase(seq, any_entry());
+    streams.insert(seq, std::move(handler));
+  }
+
+  void remove(seq_type seq) {
+    streams.erase(seq, any_entry());
+  }
+};
+
+}  // namespace detail
+
+/**
+ * Stream response: one request, many response items.
+ * Items are sent while the peer has credit, otherwise queued, use writable()/on_writable for backpressure.
+ */
+template <typename Req, typename Item>
+class stream_response_impl : public detail::stream_handler,
+                             public std::enable_shared_from_this<stream_response_impl<Req, Item>>,
+                             private detail::noncopyable {
+  using stream_response_t = stream_response_impl<Req, Item>;
+  friend class rpc;
+
+ public:
+  static std::shared_ptr<stream_response_t> create() {
+    struct helper : public stream_response_t {
+      explicit helper() : stream_response_t() {}
+    };
+    return std::make_shared<helper>();
+  }
+
+ private:
+  stream_response_impl() = default;
+
+ public:
+  /**
+   * dropped without end(): queued items are discarded, peer finishes with canceled
+   */
+  ~stream_response_impl() {
+    if (finished_) return;
+    queue_.clear();
+    finish(end_type::abort);
+  }
+
+ public:
+  Req req;
+  using ItemType = Item;
+
+  /**
+   * @return false if the stream is ended or canceled
+   */
+  bool write(const Item& item) {
+    if (ending_ || finished_) return false;
+    queue_.push_back(serialize(item));
+    flush();
+    return true;
+  }
+
+  /**
+   * end of stream, queued items are sent first
+   */
+  void end() {
+    if (ending_ || finished_) return;
+    ending_ = true;
+    flush();
+  }
+
+  bool is_canceled() const {
+    return canceled_;
+  }
+
+  bool is_finished() const {
+    return finished_;
+  }
+
+  /**
+   * true if next write will be sent immediately
+   */
+  bool writable() const {
+    return !ending_ && !finished_ && queue_.empty() && credit_ > 0;
+  }
+
+  size_t queued_size() const {
+    return queue_.size();
+  }
+
+  /**
+   * called when peer grants credit and the stream becomes writable
+   */
+  std::function<void()> on_writable;
+  std::function<void()> on_cancel;
+
+ private:
+  void add_credit(uint32_t credit) override {
+    credit_ += credit;
+    flush();
+    if (on_writable && writable()) {
+      on_writable();
+    }
+  }
+
+  void peer_cancel() override {
+    if (finished_) return;
+    RPC_CORE_LOGD("stream seq:%u canceled by peer", seq_);
+    canceled_ = true;
+    queue_.clear();
+    // peer has finished the request
+    finish(end_type::none);
+    if (on_cancel) {
+      on_cancel();
+    }
+  }
+
+  void flush() {
+    if (finished_) return;
+    auto dispatcher = dispatcher_.lock();
+    if (!dispatcher) return;
+    while (credit_ > 0 && !queue_.empty()) {
+      detail::msg_wrapper msg;
+      msg.seq = seq_;
+      msg.type = static_cast<detail::msg_wrapper::msg_type>(detail::msg_wrapper::response | detail::msg_wrapper::need_rsp);
+      msg.request_payload = &queue_.front();
+      dispatcher->send_msg(msg);
+      queue_.pop_front();
+      --credit_;
+    }
+    if (ending_ && queue_.empty()) {
+      finish(end_type::normal);
+    }
+  }
+
+  enum class end_type {
+    none,
+    normal,
+    abort,
+  };
+
+  void finish(end_type type) {
+    finished_ = true;
+    auto registry = registry_.lock();
+    if (registry) {
+      registry->remove(seq_);
+    }
+    auto dispatcher = dispatcher_.lock();
+    if (dispatcher && type != end_type::none) {
+      detail::msg_wrapper msg;
+      msg.seq = seq_;
+      msg.type = detail::msg_wrapper::response;
+      if (type == end_type::abort) {
+        msg.data = detail::StreamAbortPayload;
+      }
+      dispatcher->send_msg(msg);
+    }
+  }
+
+ private:
+  seq_type seq_ = 0;
+  std::weak_ptr<detail::msg_dispatcher> dispatcher_;
+  std::weak_ptr<detail::stream_registry> registry_;
+  std::deque<std::string> queue_;
+  uint32_t credit_ = 0;
+  bool ending_ = false;
+  bool finished_ = false;
+  bool canceled_ = false;
+};
+
+template <typename Req, typename Item>
+using stream_response = std::shared_ptr<rpc_core::stream_response_impl<Req, Item>>;
+
+namespace detail {
+
+template <typename T>
+struct is_stream_response : std::false_type {};
+
+template <typename... Args>
+struct is_stream_response<std::shared_ptr<rpc_core::stream_response_impl<Args...>>> : std::true_type {};
+
+template <typename F, bool ONE_PARAM = false>
+struct fp_is_stream_response_helper {
+  static constexpr bool value = false;
+};
+
+template <typename F>
+struct fp_is_stream_response_helper<F, true> {
+  using stream_response = detail::remove_cvref_t<typename detail::callable_traits<F>::template argument_type<0>>;
+  static constexpr bool value = detail::is_stream_response<stream_response>::value;
+};
+
+template <typename F>
+struct fp_is_stream_response {
+  static constexpr bool ONE_PARAM = detail::callable_traits<F>::argc == 1;
+  static constexpr bool value = fp_is_stream_response_helper<F, ONE_PARAM>::value;
+};
+
+}  // namespace detail
+
+}  // namespace rpc_core
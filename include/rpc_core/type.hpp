@@ -14,4 +14,6 @@ using cmd_type = std::string;
 
 using seq_type = uint32_t;
 
+using cmd_id_type = uint32_t;
+
 }  // namespace rpc_core
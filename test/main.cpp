@@ -13,6 +13,10 @@ int main() {
   RPC_CORE_LOG("test_serialize...");
   test_serialize();
 
+  printf("\n");
+  RPC_CORE_LOG("test_serialize_fuzz...");
+  test_serialize_fuzz();
+
   printf("\n");
   RPC_CORE_LOG("test_data_packer...");
   test_data_packer();
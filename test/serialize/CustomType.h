@@ -44,6 +44,21 @@ struct CustomType3 {
 #pragma pack(pop)
 RPC_CORE_DEFINE_TYPE(CustomType3, id1, id2, id3);
 
+// 线上布局与内存相同: 一次 memcpy
+struct CustomTypePod {
+  int16_t a{};
+  uint16_t b{};
+  float c{};
+  double d{};
+  bool operator==(const CustomTypePod& t) const {
+    return std::tie(a, b, c, d) == std::tie(t.a, t.b, t.c, t.d);
+  }
+};
+RPC_CORE_DEFINE_TYPE(CustomTypePod, a, b, c, d);
+static_assert(rpc_core::is_pod_on_wire<CustomTypePod>::value, "");
+static_assert(!rpc_core::is_pod_on_wire<CustomType2>::value, "");
+static_assert(!rpc_core::is_pod_on_wire<CustomType>::value, "");
+
 namespace test {
 // 嵌套定义
 struct CustomTypeNest {
@@ -62,4 +77,21 @@ struct CustomTypeNest2 {
   RPC_CORE_DEFINE_TYPE_INNER(c2, c3, ptr);
 };
 
+// 带标签定义: 字段可增删/重排
+struct CustomTypeTaggedV1 {
+  uint32_t id = 0;
+  std::string name;
+};
+RPC_CORE_DEFINE_TYPE_TAGGED(test::CustomTypeTaggedV1, (1, id), (2, name));
+
+struct CustomTypeTaggedV2 {
+  std::string name;
+  bool flag = false;
+  uint32_t id = 0;
+  double score = 0;
+  CustomType custom;
+  int64_t count = 0;
+  RPC_CORE_DEFINE_TYPE_TAGGED_INNER((2, name), (3, flag), (1, id), (4, score), (5, custom), (200, count));
+};
+
 }  // namespace test
@@ -4,6 +4,8 @@ namespace rpc_core_test {
 
 void test_serialize();
 
+void test_serialize_fuzz();
+
 void test_data_packer();
 
 void test_rpc();
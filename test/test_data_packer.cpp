@@ -1,5 +1,6 @@
 #include <ctime>
 #include <random>
+#include <vector>
 
 #include "assert_def.h"
 #include "rpc_core.hpp"
@@ -30,6 +31,19 @@ static void test_simple() {
   ASSERT(packedData2 == packedData);
   RPC_CORE_LOGI("packedData2 PASS");
 
+  RPC_CORE_LOGI("pack segments...");
+  rpc_core::detail::string_view segments[] = {{testData.data(), 5}, {testData.data() + 5, testData.size() - 5}};
+  ASSERT(packer.pack(segments, 2) == packedData);
+  std::string packedData3;
+  packer.pack(segments, 2, [&](const rpc_core::detail::string_view *iov, size_t count) {
+    ASSERT(count == 3);
+    for (size_t i = 0; i < count; ++i) {
+      packedData3.append(iov[i].data(), iov[i].size());
+    }
+  });
+  ASSERT(packedData3 == packedData);
+  RPC_CORE_LOGI("pack segments PASS");
+
   RPC_CORE_LOGI("feed again...");
   feedRecData.clear();
   ASSERT(testData != feedRecData);
@@ -85,11 +99,43 @@ static void test_random() {
   ASSERT(pass);
 }
 
+static void test_view() {
+  RPC_CORE_LOGI();
+  RPC_CORE_LOGI("test_view...");
+  rpc_core::detail::data_packer packer;
+  std::vector<std::string> testData = {"hello", "", "world"};
+  std::string packedData;
+  for (const auto &item : testData) {
+    packedData += packer.pack(item);
+  }
+
+  std::vector<std::string> feedRecData;
+  std::vector<const char *> feedRecPtr;
+  packer.on_data_view = [&](const rpc_core::detail::string_view &data) {
+    feedRecData.emplace_back(data.data(), data.size());
+    feedRecPtr.push_back(data.data());
+  };
+
+  RPC_CORE_LOGI("complete packages should point into fed data...");
+  packer.feed(packedData.data(), packedData.size());
+  ASSERT(feedRecData == testData);
+  ASSERT(feedRecPtr[0] == packedData.data() + 4);
+  ASSERT(feedRecPtr[2] == packedData.data() + packedData.size() - testData[2].size());
+
+  RPC_CORE_LOGI("split packages...");
+  feedRecData.clear();
+  for (char c : packedData) {
+    packer.feed(&c, 1);
+  }
+  ASSERT(feedRecData == testData);
+}
+
 namespace rpc_core_test {
 
 void test_data_packer() {
   test_simple();
   test_random();
+  test_view();
 }
 
 }  // namespace rpc_core_test
@@ -1,10 +1,89 @@
+#include <algorithm>
+
+#ifdef RPC_CORE_FEATURE_THREAD_SAFE
+#include <atomic>
+#include <thread>
+#endif
+
 #include "assert_def.h"
 #include "rpc_core.hpp"
+#include "rpc_core/detail/varint.hpp"
 #include "serialize/CustomType.h"
 #include "test.h"
 
 namespace rpc_core_test {
 
+/**
+ * A pair of connected connections, packages are queued until delivered manually, or delivered at once if sync.
+ */
+struct queued_connection : rpc_core::detail::noncopyable {
+  queued_connection() {
+    a->send_package_impl = [this](std::string package) {
+      send(to_b, *b, std::move(package));
+    };
+    b->send_package_impl = [this](std::string package) {
+      send(to_a, *a, std::move(package));
+    };
+  }
+
+  /**
+   * deliver packages queued before the call, return the count
+   */
+  size_t deliver_a() {
+    return deliver(to_a, *a);
+  }
+
+  size_t deliver_b() {
+    return deliver(to_b, *b);
+  }
+
+  std::shared_ptr<rpc_core::connection> a = std::make_shared<rpc_core::connection>();
+  std::shared_ptr<rpc_core::connection> b = std::make_shared<rpc_core::connection>();
+  std::vector<std::string> to_a;
+  std::vector<std::string> to_b;
+  size_t sent_bytes = 0;
+  bool sync = false;
+
+ private:
+  void send(std::vector<std::string>& packages, rpc_core::connection& conn, std::string package) {
+    sent_bytes += package.size();
+    if (sync) {
+      conn.on_recv_package(std::move(package));
+    } else {
+      packages.push_back(std::move(package));
+    }
+  }
+
+  static size_t deliver(std::vector<std::string>& packages, rpc_core::connection& conn) {
+    auto tmp = std::move(packages);
+    packages.clear();
+    for (auto& p : tmp) {
+      conn.on_recv_package(std::move(p));
+    }
+    return tmp.size();
+  }
+};
+
+/**
+ * A pair of ready rpc on the two ends of a connection, requests of a time out by the timing wheel.
+ */
+struct rpc_pair : rpc_core::detail::noncopyable {
+  rpc_pair() : rpc_pair(rpc_core::loopback_connection::create()) {}
+
+  explicit rpc_pair(const std::pair<std::shared_ptr<rpc_core::connection>, std::shared_ptr<rpc_core::connection>>& conn)
+      : rpc_pair(conn.first, conn.second) {}
+
+  rpc_pair(std::shared_ptr<rpc_core::connection> conn_a, std::shared_ptr<rpc_core::connection> conn_b)
+      : a(rpc_core::rpc::create(std::move(conn_a))), b(rpc_core::rpc::create(std::move(conn_b))) {
+    a->set_timing_wheel();
+    a->set_ready(true);
+    b->set_ready(true);
+  }
+
+  std::shared_ptr<rpc_core::rpc> a;
+  std::shared_ptr<rpc_core::rpc> b;
+};
+
 void test_rpc() {
   using namespace rpc_core;
 
@@ -157,6 +236,68 @@ void test_rpc() {
     ASSERT(pass);
   }
 
+  RPC_CORE_LOG("1.1 use cmd id");
+  {
+    rpc_c->set_use_cmd_id(true);
+    bool pass = false;
+    rpc_c->call("cmd1", std::string("test"), [&](const std::string& rsp) {
+      ASSERT(rsp == "ok");
+      pass = true;
+    });
+    ASSERT(pass);
+
+    pass = false;
+    rpc_c->cmd("cmd_xx")
+        ->mark_need_rsp()
+        ->finally([&](finally_t type) {
+          ASSERT(type == finally_t::no_such_cmd);
+          pass = true;
+        })
+        ->call();
+    ASSERT(pass);
+
+    pass = false;
+    rpc_s->unsubscribe("cmd1");
+    rpc_c->cmd("cmd1")
+        ->mark_need_rsp()
+        ->finally([&](finally_t type) {
+          ASSERT(type == finally_t::no_such_cmd);
+          pass = true;
+        })
+        ->call();
+    ASSERT(pass);
+
+    // cmds with the same id are ambiguous, but still work by cmd
+    ASSERT(detail::make_cmd_id(detail::string_view("cmd60608")) == detail::make_cmd_id(detail::string_view("cmd890692")));
+    rpc_s->subscribe("cmd60608", [] {
+      return std::string("cmd60608");
+    });
+    rpc_s->subscribe("cmd890692", [] {
+      return std::string("cmd890692");
+    });
+    for (const char* cmd : {"cmd60608", "cmd890692"}) {
+      pass = false;
+      rpc_c->cmd(cmd)
+          ->rsp([](const std::string&) {
+            ASSERT(false);
+          })
+          ->finally([&](finally_t type) {
+            ASSERT(type == finally_t::no_such_cmd);
+            pass = true;
+          })
+          ->call();
+      ASSERT(pass);
+    }
+    rpc_c->set_use_cmd_id(false);
+    pass = false;
+    rpc_c->cmd("cmd890692")->rsp([&](const std::string& rsp) {
+      pass = rsp == "cmd890692";
+    })->call();
+    ASSERT(pass);
+    rpc_s->unsubscribe("cmd60608");
+    rpc_s->unsubscribe("cmd890692");
+  }
+
   RPC_CORE_LOG("2. test complex structures(including STL containers)");
   {
     bool pass = false;
@@ -418,6 +559,741 @@ void test_rpc() {
     ASSERT(pass_rsp);
   }
 
+  RPC_CORE_LOG("11.1 many pending responses, respond out of order");
+  {
+    std::vector<request_response<uint32_t, uint32_t>> pending;
+    rpc_s->subscribe("cmd_pending", [&](request_response<uint32_t, uint32_t> rr) {
+      pending.push_back(std::move(rr));
+    });
+    const uint32_t count = 1000;
+    uint32_t rsp_count = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      rpc_c->cmd("cmd_pending")
+          ->msg(i)
+          ->rsp([&, i](uint32_t value) {
+            ASSERT(value == i * 2);
+            ++rsp_count;
+          })
+          ->call();
+    }
+    ASSERT(pending.size() == count);
+    for (size_t i = 0; i < pending.size(); i += 2) {
+      pending[i]->rsp(pending[i]->req * 2);
+    }
+    for (size_t i = pending.size(); i-- > 0;) {
+      if (i % 2) pending[i]->rsp(pending[i]->req * 2);
+    }
+    ASSERT(rsp_count == count);
+    rpc_s->unsubscribe("cmd_pending");
+  }
+
+  RPC_CORE_LOG("11.2 timeout and retry");
+  {
+    auto conn = loopback_connection::create();
+    auto rpc_a = rpc::create(conn.first);
+    auto rpc_b = rpc::create(conn.second);
+    std::vector<rpc::timeout_cb> timers;
+    rpc_a->set_timer([&](uint32_t ms, rpc::timeout_cb cb) {
+      RPC_CORE_UNUSED(ms);
+      timers.push_back(std::move(cb));
+    });
+    rpc_a->set_ready(true);
+    rpc_b->set_ready(true);
+
+    int timeout_count = 0;
+    finally_t finally_type = finally_t::normal;
+    rpc_a->cmd("no_rsp")
+        ->rsp([] {
+          ASSERT(false);
+        })
+        ->timeout([&] {
+          ++timeout_count;
+        })
+        ->finally([&](finally_t type) {
+          finally_type = type;
+        })
+        ->retry(1)
+        ->call();
+    rpc_b->subscribe("no_rsp", [](request_response<std::string, std::string> rr) {
+      RPC_CORE_UNUSED(rr);
+    });
+    // no_such_cmd response already finished the first call
+    ASSERT(finally_type == finally_t::no_such_cmd);
+    ASSERT(timers.size() == 1);
+    timers[0]();
+    ASSERT(timeout_count == 0);
+
+    rpc_a->cmd("no_rsp")
+        ->rsp([] {
+          ASSERT(false);
+        })
+        ->timeout([&] {
+          ++timeout_count;
+        })
+        ->finally([&](finally_t type) {
+          finally_type = type;
+        })
+        ->retry(1)
+        ->call();
+    ASSERT(timers.size() == 2);
+    timers[1]();
+    ASSERT(timeout_count == 1);
+    ASSERT(timers.size() == 3);
+    timers[2]();
+    ASSERT(timeout_count == 2);
+    ASSERT(finally_type == finally_t::timeout);
+  }
+
+  RPC_CORE_LOG("11.3 timing wheel");
+  {
+    rpc_pair peers;
+    peers.a->set_timing_wheel(10, 8);
+
+    std::vector<request_response<std::string, std::string>> pending;
+    peers.b->subscribe("wait", [&](request_response<std::string, std::string> rr) {
+      pending.push_back(std::move(rr));
+    });
+
+    int timeout_count = 0;
+    int rsp_count = 0;
+    auto call = [&](uint32_t timeout_ms) {
+      peers.a->cmd("wait")
+          ->rsp([&] {
+            ++rsp_count;
+          })
+          ->timeout([&] {
+            ++timeout_count;
+          })
+          ->timeout_ms(timeout_ms)
+          ->call();
+    };
+
+    uint32_t now = 0xffffff00;  // test wrap around
+    peers.a->tick(now);
+    call(50);
+    call(50);
+    call(500);  // more than one round
+    pending[1]->rsp("");
+    ASSERT(rsp_count == 1);
+
+    peers.a->tick(now += 40);
+    ASSERT(timeout_count == 0);
+    peers.a->tick(now += 20);
+    ASSERT(timeout_count == 1);
+    peers.a->tick(now += 100);
+    ASSERT(timeout_count == 1);
+    for (int i = 0; i < 40; ++i) {
+      peers.a->tick(now += 10);
+    }
+    ASSERT(timeout_count == 2);
+    pending[0]->rsp("");
+    ASSERT(rsp_count == 1);
+
+    // entries are removed on finish, and replaced on add
+    detail::timing_wheel wheel(10, 4);
+    std::vector<seq_type> expired;
+    wheel.tick(0, expired);
+    for (seq_type seq = 0; seq < 10; ++seq) {
+      wheel.add(seq, 30);
+    }
+    wheel.add(9, 60);
+    ASSERT(wheel.size() == 10);
+    for (seq_type seq = 0; seq < 10; seq += 2) {
+      wheel.remove(seq);
+    }
+    wheel.remove(100);
+    ASSERT(wheel.size() == 5);
+    wheel.tick(30, expired);
+    std::sort(expired.begin(), expired.end());
+    ASSERT((expired == std::vector<seq_type>{1, 3, 5, 7}));
+    ASSERT(wheel.size() == 1);
+    wheel.tick(60, expired);
+    ASSERT(expired.back() == 9);
+    ASSERT(wheel.size() == 0);
+  }
+
+#ifdef RPC_CORE_FEATURE_THREAD_SAFE
+  RPC_CORE_LOG("11.4 thread safe call");
+  {
+    rpc_pair peers;
+    peers.b->subscribe("add", [](uint32_t v) -> uint32_t {
+      return v + 1;
+    });
+
+    const uint32_t thread_count = 4;
+    const uint32_t call_count = 1000;
+    std::atomic<uint32_t> rsp_count{0};
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thread_count; ++t) {
+      threads.emplace_back([&, t] {
+        for (uint32_t i = 0; i < call_count; ++i) {
+          uint32_t v = t * call_count + i;
+          peers.a->cmd("add")
+              ->msg(v)
+              ->rsp([&, v](uint32_t r) {
+                ASSERT(r == v + 1);
+                ++rsp_count;
+              })
+              ->call();
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    ASSERT(rsp_count == thread_count * call_count);
+  }
+#endif
+
+  RPC_CORE_LOG("11.5 rpc pool");
+  {
+    auto pool_s = rpc_pool::create();
+    auto pool_c = rpc_pool::create(rpc_pool::policy::least_outstanding);
+    std::vector<request_response<uint32_t, uint32_t>> pending;
+    pool_s->subscribe("pool", [&](request_response<uint32_t, uint32_t> rr) {
+      pending.push_back(std::move(rr));
+    });
+
+    // empty pool
+    finally_t empty_finally = finally_t::normal;
+    pool_c->cmd("pool")->msg(uint32_t(0))->rsp([](uint32_t) {})->finally([&](finally_t type) {
+      empty_finally = type;
+    })->call();
+    ASSERT(empty_finally == finally_t::rpc_expired);
+    for (int i = 0; i < 3; ++i) {
+      auto conn = loopback_connection::create();
+      auto s = rpc::create(conn.first);
+      auto c = rpc::create(conn.second);
+      s->set_timing_wheel();
+      c->set_timing_wheel();
+      s->set_ready(true);
+      c->set_ready(true);
+      // keep connection alive by rpc
+      pool_s->add(s);
+      pool_c->add(c);
+    }
+    // subscribe after add also applies to all
+    pool_s->subscribe("echo", [](uint32_t v) {
+      return v;
+    });
+
+    uint32_t rsp_count = 0;
+    for (uint32_t i = 0; i < 6; ++i) {
+      pool_c->cmd("pool")->msg(i)->rsp([&](uint32_t) {
+        ++rsp_count;
+      })->call();
+    }
+    ASSERT(pending.size() == 6);
+    // least outstanding spreads requests evenly
+    for (const auto& rpc : pool_c->rpcs()) {
+      ASSERT(rpc->pending_size() == 2);
+    }
+    auto stats = pool_c->get_stats();
+    ASSERT(stats.rpc_count == 3);
+    ASSERT(stats.ready_count == 3);
+    ASSERT(stats.pending_count == 6);
+    ASSERT(stats.routed_count == 6);
+    for (auto& rr : pending) {
+      rr->rsp(rr->req);
+    }
+    ASSERT(rsp_count == 6);
+    ASSERT(pool_c->get_stats().pending_count == 0);
+
+    pool_c->set_policy(rpc_pool::policy::key_hash);
+    ASSERT(pool_c->select("key") == pool_c->select("key"));
+    pool_c->set_policy(rpc_pool::policy::round_robin);
+    ASSERT(pool_c->select() != pool_c->select());
+
+    uint32_t echo_count = 0;
+    for (uint32_t i = 0; i < 3; ++i) {
+      pool_c->cmd("echo")->msg(i)->rsp([&, i](uint32_t v) {
+        ASSERT(v == i);
+        ++echo_count;
+      })->call();
+    }
+    ASSERT(echo_count == 3);
+  }
+
+  RPC_CORE_LOG("11.6 request window");
+  {
+    rpc_pair peers;
+    std::vector<request_response<std::string, std::string>> pending;
+    peers.b->subscribe("window", [&](request_response<std::string, std::string> rr) {
+      pending.push_back(std::move(rr));
+    });
+
+    peers.a->set_window(2);
+    int open_count = 0;
+    peers.a->on_window_open([&] {
+      ++open_count;
+    });
+    std::vector<std::string> rsp_order;
+    auto call = [&](std::string msg) {
+      return peers.a->cmd("window")->msg(std::move(msg))->rsp([&](const std::string& rsp) {
+        rsp_order.push_back(rsp);
+      });
+    };
+    call("0")->call();
+    call("1")->call();
+    ASSERT(peers.a->is_window_full());
+    call("2")->call();
+    auto canceled = call("3");
+    canceled->call();
+    call("4")->call();
+    ASSERT(pending.size() == 2);
+    ASSERT(peers.a->window_queued_size() == 3);
+    canceled->cancel();
+
+    pending[1]->rsp(pending[1]->req);
+    ASSERT(pending.size() == 3);
+    ASSERT(pending[2]->req == "2");
+    pending[0]->rsp(pending[0]->req);
+    ASSERT(pending.size() == 4);
+    ASSERT(pending[3]->req == "4");
+    ASSERT(peers.a->window_queued_size() == 0);
+    ASSERT(open_count == 1);
+    pending[2]->rsp(pending[2]->req);
+    pending[3]->rsp(pending[3]->req);
+    ASSERT((rsp_order == std::vector<std::string>{"1", "0", "2", "4"}));
+    ASSERT(!peers.a->is_window_full());
+    ASSERT(open_count == 1);
+
+    // limit by bytes
+    pending.clear();
+    peers.a->set_window(0, 8);
+    call("12345")->call();
+    call("12345")->call();
+    ASSERT(pending.size() == 1);
+    pending[0]->rsp("");
+    ASSERT(pending.size() == 2);
+    ASSERT(open_count == 2);
+    pending[1]->rsp("");
+    ASSERT(peers.a->pending_size() == 0);
+  }
+
+  RPC_CORE_LOG("11.7 chunked stream");
+  {
+    queued_connection conn;
+    rpc_pair peers(conn.a, conn.b);
+
+    const size_t total = 1000;
+    const size_t chunk_size = 64;
+    std::string received;
+    uint32_t next_index = 0;
+    bool end = false;
+    subscribe_stream(peers.b, "file", [&](const stream_chunk& chunk) {
+      ASSERT(chunk.index == next_index++);
+      received += chunk.data;
+      end = chunk.end;
+      return true;
+    });
+
+    size_t produced = 0;
+    finally_t finally_type = finally_t::no_need_rsp;
+    auto sender = stream_sender::create(
+        peers.a, "file",
+        [&](std::string& data) {
+          size_t size = std::min(chunk_size, total - produced);
+          data.assign(size, char('a' + produced / chunk_size));
+          produced += size;
+          return produced < total;
+        },
+        3);
+    sender->on_finish([&](finally_t type) {
+      finally_type = type;
+    });
+    sender->start();
+    ASSERT(conn.to_b.size() == 3);
+    while (conn.deliver_b()) {
+      ASSERT(conn.deliver_a() <= 3);
+    }
+    ASSERT(end);
+    ASSERT(received.size() == total);
+    ASSERT(received.back() == char('a' + (total - 1) / chunk_size));
+    ASSERT(finally_type == finally_t::normal);
+    ASSERT(sender->sent_count() == (total + chunk_size - 1) / chunk_size);
+
+    // reject by receiver, abort chunk is the last one
+    std::vector<stream_chunk> chunks;
+    subscribe_stream(peers.b, "file", [&](const stream_chunk& chunk) {
+      chunks.push_back(chunk);
+      return chunk.index < 2;
+    });
+    produced = 0;
+    auto producer = [&](std::string& data) {
+      data = "x";
+      return ++produced < total;
+    };
+    sender = stream_sender::create(peers.a, "file", producer);
+    sender->on_finish([&](finally_t type) {
+      finally_type = type;
+    });
+    sender->start();
+    while (conn.deliver_b()) {
+      conn.deliver_a();
+    }
+    ASSERT(finally_type == finally_t::canceled);
+    ASSERT(produced < 10);
+    ASSERT(chunks.back().end && chunks.back().abort);
+    ASSERT(chunks.back().index == sender->sent_count());
+    ASSERT(peers.a->pending_size() == 0);
+
+    // cancel by sender
+    chunks.clear();
+    sender = stream_sender::create(peers.a, "file", producer);
+    sender->start();
+    conn.deliver_b();
+    sender->cancel();
+    conn.deliver_b();
+    ASSERT(chunks.size() == 5);
+    ASSERT(!chunks[3].end);
+    ASSERT(chunks[4].end && chunks[4].abort && chunks[4].id == chunks[0].id);
+    // acks of the canceled chunks finish their requests
+    ASSERT(conn.deliver_a() == 4);
+    ASSERT(peers.a->pending_size() == 0);
+
+    // rpc is held weakly
+    chunks.clear();
+    sender = stream_sender::create(peers.a, "file", producer);
+    sender->on_finish([&](finally_t type) {
+      finally_type = type;
+    });
+    peers.a = nullptr;
+    sender->start();
+    ASSERT(finally_type == finally_t::rpc_expired);
+    ASSERT(conn.to_b.empty());
+  }
+
+  RPC_CORE_LOG("11.8 stream response");
+  {
+    queued_connection conn;
+    rpc_pair peers(conn.a, conn.b);
+
+    stream_response<uint32_t, uint32_t> stream;
+    bool peer_canceled = false;
+    peers.b->subscribe("numbers", [&](stream_response<uint32_t, uint32_t> s) {
+      for (uint32_t i = 0; i < s->req; ++i) {
+        s->write(i);
+      }
+      s->on_cancel = [&] {
+        peer_canceled = true;
+      };
+      stream = std::move(s);
+    });
+
+    std::vector<uint32_t> items;
+    finally_t finally_type = finally_t::no_need_rsp;
+    peers.a->cmd("numbers")
+        ->msg(uint32_t(10))
+        ->rsp_stream(
+            [&](uint32_t item) {
+              items.push_back(item);
+            },
+            4)
+        ->finally([&](finally_t type) {
+          finally_type = type;
+        })
+        ->call();
+    ASSERT(peers.a->pending_size() == 1);
+    // request and initial credit
+    ASSERT(conn.deliver_b() == 2);
+    ASSERT(stream->queued_size() == 6);
+    ASSERT(conn.to_a.size() == 4);
+    while (conn.deliver_b() + conn.deliver_a()) {
+      ASSERT(stream->queued_size() + items.size() <= 10);
+      ASSERT(conn.to_a.size() <= 4);
+    }
+    ASSERT(items.size() == 10);
+    ASSERT(items[9] == 9);
+    ASSERT(stream->writable());
+    ASSERT(finally_type == finally_t::no_need_rsp);
+    stream->write(10);
+    stream->end();
+    ASSERT(!stream->write(11));
+    conn.deliver_a();
+    ASSERT(items.size() == 11);
+    ASSERT(finally_type == finally_t::normal);
+    ASSERT(peers.a->pending_size() == 0);
+
+    // cancel by client
+    auto request = peers.a->cmd("numbers")->msg(uint32_t(100))->rsp_stream([&](uint32_t) {});
+    request->finally([&](finally_t type) {
+      finally_type = type;
+    });
+    request->call();
+    conn.deliver_b();
+    request->cancel();
+    ASSERT(finally_type == finally_t::canceled);
+    conn.to_a.clear();
+    conn.deliver_b();
+    ASSERT(peer_canceled);
+    // no end response for canceled request
+    ASSERT(conn.to_a.empty());
+    ASSERT(stream->is_canceled());
+    ASSERT(peers.a->pending_size() == 0);
+
+    // dropped without end, queued items are discarded
+    peers.b->subscribe("drop", [&](stream_response<uint32_t, uint32_t> s) {
+      for (uint32_t i = 0; i < s->req; ++i) {
+        s->write(i);
+      }
+    });
+    items.clear();
+    peers.a->cmd("drop")
+        ->msg(uint32_t(10))
+        ->rsp_stream(
+            [&](uint32_t item) {
+              items.push_back(item);
+            },
+            4)
+        ->finally([&](finally_t type) {
+          finally_type = type;
+        })
+        ->call();
+    while (conn.deliver_b() + conn.deliver_a()) {
+    }
+    // initial credit arrives after the request, all items were queued
+    ASSERT(items.empty());
+    ASSERT(finally_type == finally_t::canceled);
+    ASSERT(peers.a->pending_size() == 0);
+
+    // timeout_ms is idle timeout, stream lasts longer than it
+    uint32_t now_ms = 0;
+    peers.a->tick(now_ms);
+    items.clear();
+    finally_type = finally_t::no_need_rsp;
+    request = peers.a->cmd("numbers")
+                  ->msg(uint32_t(0))
+                  ->rsp_stream([&](uint32_t item) {
+                    items.push_back(item);
+                  })
+                  ->timeout_ms(100)
+                  ->retry(-1)
+                  ->finally([&](finally_t type) {
+                    finally_type = type;
+                  });
+    request->call();
+    conn.deliver_b();
+    for (uint32_t i = 0; i < 10; ++i) {
+      stream->write(i);
+      conn.deliver_a();
+      conn.deliver_b();
+      peers.a->tick(now_ms += 60);
+    }
+    ASSERT(items.size() == 10);
+    ASSERT(finally_type == finally_t::no_need_rsp);
+    stream->end();
+    conn.deliver_a();
+    ASSERT(finally_type == finally_t::normal);
+
+    // idle: timeout without retry, peer is canceled
+    peer_canceled = false;
+    request->call();
+    conn.deliver_b();
+    peers.a->tick(now_ms += 300);
+    ASSERT(finally_type == finally_t::timeout);
+    ASSERT(peers.a->pending_size() == 0);
+    conn.deliver_b();
+    ASSERT(peer_canceled);
+  }
+
+  RPC_CORE_LOG("11.9 compression");
+  {
+    queued_connection conn;
+    conn.sync = true;
+    rpc_pair peers(conn.a, conn.b);
+    peers.b->subscribe("echo", [](const std::string& msg) {
+      return msg;
+    });
+
+    std::string data;
+    for (int i = 0; i < 100; ++i) {
+      data += "compressible payload " + std::to_string(i % 10) + ";";
+    }
+    auto echo = [&] {
+      bool ok = false;
+      conn.sent_bytes = 0;
+      peers.a->cmd("echo")->msg(data)->rsp([&](const std::string& rsp) {
+        ok = rsp == data;
+      })->call();
+      ASSERT(ok);
+      return conn.sent_bytes;
+    };
+    size_t raw_bytes = echo();
+    ASSERT(raw_bytes > data.size() * 2);
+
+    // decompression is opt-in, and limited
+    peers.a->set_compression();
+    bool received = false;
+    peers.a->cmd("echo")->msg(data)->rsp([&](const std::string&) {
+      received = true;
+    })->call();
+    ASSERT(!received);
+    peers.b->set_decompression(data.size() - 1);
+    peers.a->cmd("echo")->msg(data)->rsp([&](const std::string&) {
+      received = true;
+    })->call();
+    ASSERT(!received);
+    peers.b->set_decompression();
+    // rejected requests time out
+    ASSERT(peers.a->pending_size() == 2);
+    peers.a->tick(0);
+    peers.a->tick(10000);
+    ASSERT(peers.a->pending_size() == 0);
+
+    // only requests are compressed
+    size_t req_compressed = echo();
+    ASSERT(req_compressed < raw_bytes);
+    peers.b->set_compression();
+    size_t both_compressed = echo();
+    ASSERT(both_compressed < req_compressed);
+
+    // small and incompressible payloads are sent as is
+    data = "small";
+    ASSERT(echo() < 64);
+    data.clear();
+    uint32_t seed = 1;
+    for (int i = 0; i < 1000; ++i) {
+      seed = seed * 1103515245 + 12345;
+      data.push_back((char)(seed >> 16));
+    }
+    ASSERT(echo() > data.size() * 2);
+  }
+
+  RPC_CORE_LOG("11.10 coder unaligned header");
+  {
+    detail::msg_wrapper msg;
+    msg.seq = 0x12345678;
+    msg.cmd = "cmd";
+    msg.type = detail::msg_wrapper::command;
+    msg.data = "data";
+    auto payload = detail::coder::serialize(msg);
+    // decode at an odd address
+    std::string buffer = "_" + payload;
+    bool ok;
+    auto decoded = detail::coder::deserialize(detail::string_view(buffer.data() + 1, payload.size()), ok);
+    ASSERT(ok);
+    ASSERT(decoded.seq == msg.seq);
+    ASSERT(decoded.cmd_view == detail::string_view("cmd"));
+    ASSERT(decoded.type == detail::msg_wrapper::command);
+    ASSERT(decoded.data_view == detail::string_view("data"));
+    detail::coder::deserialize(detail::string_view(buffer.data() + 1, payload.size() - 6), ok);
+    ASSERT(!ok);
+
+    // cmd length equal to CmdIdMark is rejected
+    msg.cmd.assign(detail::CmdIdMark, 'c');
+    ASSERT(detail::coder::serialize(msg).empty());
+    msg.cmd.pop_back();
+    payload = detail::coder::serialize(msg);
+    decoded = detail::coder::deserialize(payload, ok);
+    ASSERT(ok);
+    ASSERT(!decoded.with_cmd_id);
+    ASSERT(decoded.cmd_view.size() == detail::CmdIdMark - 1);
+
+    // varint: fast path needs 8 readable bytes, slow path handles the tail and 9-10 bytes values
+    const uint64_t values[] = {0, 1, 127, 128, 16383, 16384, UINT32_MAX, (1ULL << 56) - 1, 1ULL << 56, UINT64_MAX};
+    for (auto v : values) {
+      uint8_t buf[detail::VarintMaxBytes + 8]{};
+      auto end = detail::varint_encode(v, buf);
+      uint64_t decoded_value = 0;
+      ASSERT(detail::varint_decode(buf, buf + sizeof(buf), decoded_value) == end);
+      ASSERT(decoded_value == v);
+      ASSERT(detail::varint_decode(buf, end, decoded_value) == end);
+      ASSERT(decoded_value == v);
+      ASSERT(detail::varint_decode(buf, end - 1, decoded_value) == nullptr);
+    }
+
+#ifdef RPC_CORE_FEATURE_CODER_VARINT
+    // crafted cmd length: wraps the bounds check, or truncated to 16 bits
+    for (uint64_t cmd_len : {UINT64_MAX, UINT64_MAX - 1, (uint64_t)detail::CmdIdMark + 1 + 3}) {
+      uint8_t header[detail::VarintMaxBytes * 2];
+      auto end = detail::varint_encode(cmd_len, detail::varint_encode(1, header));
+      std::string crafted((char*)header, end - header);
+      crafted += "cmd";
+      crafted.push_back((char)detail::msg_wrapper::command);
+      detail::coder::deserialize(crafted, ok);
+      ASSERT(!ok);
+    }
+#endif
+  }
+
+  RPC_CORE_LOG("11.11 view argument");
+  {
+    // request_response/stream_response reject them
+    static_assert(detail::is_view_type<std::tuple<int, std::pair<std::string, array_view<float>>>>::value, "");
+    static_assert(!detail::is_view_type<std::tuple<int, std::string>>::value, "");
+    rpc_pair peers;
+    peers.b->subscribe("blob", [](array_view<uint8_t> blob) {
+      uint32_t sum = 0;
+      for (size_t i = 0; i < blob.size(); ++i) {
+        sum += blob[i];
+      }
+      return sum;
+    });
+    peers.b->subscribe("name", [](const detail::string_view& name) {
+      return std::string(name.data(), name.size());
+    });
+    uint32_t sum = 0;
+    peers.a->cmd("blob")->msg(std::vector<uint8_t>{1, 2, 3})->rsp([&](uint32_t v) {
+      sum = v;
+    })->call();
+    ASSERT(sum == 6);
+    std::string name;
+    peers.a->cmd("name")->msg(std::string("view"))->rsp([&](const std::string& v) {
+      name = v;
+    })->call();
+    ASSERT(name == "view");
+  }
+
+  RPC_CORE_LOG("11.12 arena");
+  {
+    rpc_pair peers;
+    peers.b->set_arena(256);
+    std::vector<std::string> copied;
+    arena_vector<arena_string> kept;
+    peers.b->subscribe("names", [&](const arena_vector<arena_string>& names) {
+      ASSERT(arena::current() != nullptr);
+      for (const auto& name : names) {
+        copied.emplace_back(name.data(), name.size());
+      }
+      // copy is on heap
+      if (kept.empty()) {
+        arena_vector<arena_string> tmp = names;
+        kept.swap(tmp);
+      }
+      return (uint32_t)names.size();
+    });
+    uint32_t count = 0;
+    peers.a->cmd("names")->msg(std::vector<std::string>{"a", std::string(1000, 'b')})->rsp([&](uint32_t v) {
+      count = v;
+    })->call();
+    ASSERT(count == 2);
+    ASSERT(copied.size() == 2 && copied[1] == std::string(1000, 'b'));
+    ASSERT(arena::current() == nullptr);
+    // arena is reused by next message, the copy is not affected
+    peers.a->cmd("names")->msg(std::vector<std::string>{std::string(1000, 'c'), "d"})->call();
+    ASSERT(copied.size() == 4);
+    ASSERT(kept.size() == 2 && kept[0] == "a" && kept[1] == arena_string(1000, 'b'));
+  }
+
+  RPC_CORE_LOG("11.13 nested call in rsp");
+  {
+    // synchronous transport re-enters dispatch while sending
+    rpc_pair peers;
+    peers.b->subscribe("echo", [](const std::string& msg) {
+      return msg;
+    });
+    std::string nested;
+    peers.a->cmd("echo")->msg(std::string("outer"))->rsp([&](const std::string& rsp) {
+      ASSERT(rsp == "outer");
+      peers.a->cmd("echo")->msg(std::string("inner"))->rsp([&](const std::string& rsp) {
+        nested = rsp;
+      })->call();
+    })->call();
+    ASSERT(nested == "inner");
+    ASSERT(peers.a->pending_size() == 0);
+  }
+
   RPC_CORE_LOG("12. subscribe async: use coroutine or custom scheduler");
 #if 0
   {
@@ -462,6 +1338,187 @@ void test_rpc() {
     }, scheduler_asio_coroutine);
   }
 #endif
+
+  RPC_CORE_LOG("13. stream connection");
+  {
+    auto conn_s = std::make_shared<stream_connection>();
+    auto conn_c = std::make_shared<stream_connection>();
+    std::string bytes_s;
+    std::string bytes_c;
+    conn_s->send_bytes_impl = [&](std::string data) {
+      bytes_c += data;
+    };
+    conn_c->send_bytes_iov_impl = [&](const detail::string_view* segments, size_t count) {
+      for (size_t i = 0; i < count; ++i) {
+        bytes_s.append(segments[i].data(), segments[i].size());
+      }
+    };
+    auto transfer = [](std::string& bytes, stream_connection& conn, size_t chunk) {
+      std::string tmp = std::move(bytes);
+      for (size_t i = 0; i < tmp.size(); i += chunk) {
+        conn.on_recv_bytes(tmp.data() + i, std::min(chunk, tmp.size() - i));
+      }
+    };
+    auto stream_s = rpc::create(conn_s);
+    stream_s->set_timer([](uint32_t ms, const rpc::timeout_cb& cb) {
+      RPC_CORE_UNUSED(ms);
+      RPC_CORE_UNUSED(cb);
+    });
+    stream_s->set_ready(true);
+    auto stream_c = rpc::create(conn_c);
+    stream_c->set_timer([](uint32_t ms, const rpc::timeout_cb& cb) {
+      RPC_CORE_UNUSED(ms);
+      RPC_CORE_UNUSED(cb);
+    });
+    stream_c->set_ready(true);
+    stream_s->subscribe("cmd", [](const std::string& msg) {
+      return msg;
+    });
+
+    for (size_t chunk : {(size_t)1, (size_t)7, (size_t)4096}) {
+      int rsp_count = 0;
+      for (int i = 0; i < 3; ++i) {
+        stream_c->call("cmd", std::to_string(i), [&rsp_count, i](const std::string& rsp) {
+          ASSERT(rsp == std::to_string(i));
+          ++rsp_count;
+        });
+      }
+      transfer(bytes_s, *conn_s, chunk);
+      transfer(bytes_c, *conn_c, chunk);
+      ASSERT(rsp_count == 3);
+    }
+
+    RPC_CORE_LOG("13.1 write coalescing");
+    std::function<void()> posted_flush;
+    conn_c->post_flush_impl = [&](std::function<void()> flush) {
+      ASSERT(!posted_flush);
+      posted_flush = std::move(flush);
+    };
+    conn_c->set_coalesce(true, 64 * 1024, 4);
+    int rsp_count = 0;
+    for (int i = 0; i < 6; ++i) {
+      stream_c->call("cmd", std::to_string(i), [&rsp_count, i](const std::string& rsp) {
+        ASSERT(rsp == std::to_string(i));
+        ++rsp_count;
+      });
+    }
+    ASSERT(conn_c->stats().flush_count == 1);  // max_frames
+    ASSERT(posted_flush);
+    posted_flush();  // end of event-loop tick
+    ASSERT(conn_c->stats().flush_count == 2);
+    ASSERT(conn_c->stats().frame_count == 6);
+    ASSERT(conn_c->stats().max_frames_per_flush == 4);
+    transfer(bytes_s, *conn_s, 4096);
+    transfer(bytes_c, *conn_c, 4096);
+    ASSERT(rsp_count == 6);
+    conn_c->set_coalesce(false);
+    {
+      // package dropped by max_body_size is not counted
+      stream_connection conn_m(8);
+      conn_m.send_bytes_impl = [](const std::string&) {};
+      conn_m.set_coalesce(true, 64 * 1024, 4);
+      conn_m.send_package_impl("too large package");
+      conn_m.send_package_impl("small");
+      conn_m.flush();
+      ASSERT(conn_m.stats().flush_count == 1);
+      ASSERT(conn_m.stats().frame_count == 1);
+      ASSERT(conn_m.stats().byte_count == 4 + 5);
+    }
+
+#ifdef RPC_CORE_FEATURE_THREAD_SAFE
+    RPC_CORE_LOG("13.1.1 write coalescing from threads");
+    {
+      auto conn_t = std::make_shared<stream_connection>();
+      std::mutex bytes_mutex;
+      std::string bytes_t;
+      conn_t->send_bytes_impl = [&](std::string data) {
+        std::lock_guard<std::mutex> lock(bytes_mutex);
+        bytes_t += data;
+      };
+      conn_t->set_coalesce(true, 1024, 16);
+      auto rpc_t = rpc::create(conn_t);
+      rpc_t->set_ready(true);
+      const int thread_count = 4;
+      const int call_count = 500;
+      std::atomic<bool> done{false};
+      std::thread loop([&] {
+        while (!done) {
+          conn_t->flush();
+        }
+      });
+      std::vector<std::thread> threads;
+      for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&] {
+          for (int i = 0; i < call_count; ++i) {
+            rpc_t->call("count", std::string(10, 'x'));
+          }
+        });
+      }
+      for (auto& t : threads) {
+        t.join();
+      }
+      done = true;
+      loop.join();
+      conn_t->flush();
+      ASSERT(conn_t->stats().frame_count == thread_count * call_count);
+
+      int recv_count = 0;
+      stream_s->subscribe("count", [&](const std::string& msg) {
+        ASSERT(msg.size() == 10);
+        ++recv_count;
+      });
+      transfer(bytes_t, *conn_s, 4096);
+      ASSERT(recv_count == thread_count * call_count);
+    }
+#endif
+
+    RPC_CORE_LOG("13.2 batch response");
+    stream_s->set_batch_response(true);
+    size_t send_count = 0;
+    conn_s->send_bytes_impl = [&](std::string data) {
+      ++send_count;
+      bytes_c += data;
+    };
+    rsp_count = 0;
+    for (int i = 0; i < 5; ++i) {
+      stream_c->call("cmd", std::to_string(i), [&rsp_count, i](const std::string& rsp) {
+        ASSERT(rsp == std::to_string(i));
+        ++rsp_count;
+      });
+    }
+    stream_c->cmd("cmd_xx")->mark_need_rsp()->finally([&](finally_t type) {
+      ASSERT(type == finally_t::no_such_cmd);
+      ++rsp_count;
+    })->call();
+    stream_c->ping()->call();
+    transfer(bytes_s, *conn_s, 4096);
+    ASSERT(send_count == 1);
+    transfer(bytes_c, *conn_c, 4096);
+    ASSERT(rsp_count == 6);
+
+    // one response is sent as normal package
+    stream_c->call("cmd", std::string("x"), [&rsp_count](const std::string& rsp) {
+      ASSERT(rsp == "x");
+      ++rsp_count;
+    });
+    transfer(bytes_s, *conn_s, 4096);
+    ASSERT(send_count == 2);
+    transfer(bytes_c, *conn_c, 4096);
+    ASSERT(rsp_count == 7);
+
+    // flush early by max_bytes
+    stream_s->set_batch_response(true, 1);
+    for (int i = 0; i < 3; ++i) {
+      stream_c->call("cmd", std::to_string(i), [&rsp_count](const std::string&) {
+        ++rsp_count;
+      });
+    }
+    transfer(bytes_s, *conn_s, 4096);
+    ASSERT(send_count == 5);
+    transfer(bytes_c, *conn_c, 4096);
+    ASSERT(rsp_count == 10);
+    stream_s->set_batch_response(false);
+  }
 }
 
 }  // namespace rpc_core_test
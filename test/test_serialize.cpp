@@ -7,11 +7,16 @@
 namespace rpc_core_test {
 
 static size_t last_serialize_size = 0;
+static bool last_size_known = false;
 
 template <typename T, typename R>
 void serialize_test(T&& a, R& b) {
+  rpc_core::serialize_size_archive sa;
+  rpc_core::detail::add_serialized_size(a, sa);
   std::string data = rpc_core::serialize(std::forward<T>(a));
   last_serialize_size = data.size();
+  last_size_known = sa.known;
+  ASSERT(!sa.known || sa.size == data.size());
   RPC_CORE_LOGI("  size: %zu", last_serialize_size);
   bool ret = rpc_core::deserialize(std::move(data), b);
   ASSERT(ret);
@@ -30,7 +35,24 @@ void raw_type_test() {
   RPC_CORE_LOGI("  <" #t ">"); \
   raw_type_test<t>();
 
-#define ASSERT_SERIALIZE_SIZE(x) ASSERT(last_serialize_size == x)
+#define ASSERT_SERIALIZE_SIZE(x) ASSERT(last_size_known && last_serialize_size == x)
+
+/**
+ * same as std::string on wire, without serialized size
+ */
+struct NoSizeString {
+  std::string data;
+};
+
+inline rpc_core::serialize_oarchive& operator>>(const NoSizeString& t, rpc_core::serialize_oarchive& oa) {
+  t.data >> oa;
+  return oa;
+}
+
+inline rpc_core::serialize_iarchive& operator<<(NoSizeString& t, rpc_core::serialize_iarchive& ia) {
+  t.data << ia;
+  return ia;
+}
 
 static bool is_little_endian() {
   int x = 1;
@@ -94,6 +116,21 @@ static void test_auto_size() {
   test_auto_uint(0xffff, 3);
   test_auto_uint(0xffffff, 4);
   test_auto_uint(uintmax_t(0xffffffff), 5);
+
+  // size_bytes is validated against input
+  {
+    auto_size a(0x123456);
+    char buf[auto_size::MaxBytes + 8]{};
+    uint8_t bytes = a.serialize(buf);
+    ASSERT(bytes == 4);
+    auto_size b;
+    ASSERT(b.deserialize(buf, sizeof(buf)) == 4);
+    ASSERT(b.value == 0x123456);
+    ASSERT(b.deserialize(buf, 3) == 0);
+    buf[0] = 9;
+    ASSERT(b.deserialize(buf, sizeof(buf)) == 0);
+    ASSERT(b.deserialize(buf, 0) == 0);
+  }
 }
 
 void test_serialize() {
@@ -579,6 +616,160 @@ void test_serialize() {
     ASSERT(a == b);
     ASSERT_SERIALIZE_SIZE(39);
   }
+
+  /// contiguous containers of raw wire type are copied in bulk
+  {
+    RPC_CORE_LOGI("raw vector/array...");
+    std::vector<float> a(1000);
+    for (size_t i = 0; i < a.size(); ++i) {
+      a[i] = (float)i / 3;
+    }
+    std::vector<float> b;
+    serialize_test(a, b);
+    ASSERT(a == b);
+    ASSERT_SERIALIZE_SIZE(3 + 1000 * 4);
+
+    std::array<uint16_t, 3> c{1, 2, 0xffff};
+    std::array<uint16_t, 3> d{};
+    serialize_test(c, d);
+    ASSERT(c == d);
+    ASSERT_SERIALIZE_SIZE(2 + 3 * 2);
+
+    // same wire format as element by element
+    std::list<float> e(a.begin(), a.end());
+    ASSERT(rpc_core::serialize(e) == rpc_core::serialize(a));
+
+    auto data = rpc_core::serialize(a);
+    data.resize(data.size() - 1);
+    ASSERT(!rpc_core::deserialize(data, b));
+  }
+
+  /// serialized size is computed ahead to reserve once
+  {
+    RPC_CORE_LOGI("serialized size...");
+    CustomType c;
+    c.id = 1;
+    c.ids = {1, 2, 3};
+    c.name = "test";
+    std::map<std::string, std::tuple<CustomType, std::vector<double>>> a{{"a", {c, {1.0, 2.0}}}, {"b", {}}};
+    rpc_core::serialize_size_archive sa;
+    rpc_core::detail::add_serialized_size(a, sa);
+    ASSERT(sa.known);
+    ASSERT(sa.size == rpc_core::serialize(a).size());
+  }
+
+  /// view types point into input without copy
+  {
+    RPC_CORE_LOGI("view types...");
+    std::tuple<std::string, std::vector<float>> a{"name", {1.f, 2.f}};
+    auto data = rpc_core::serialize(a);
+    std::tuple<rpc_core::detail::string_view, rpc_core::array_view<float>> b;
+    ASSERT(rpc_core::deserialize(data, b));
+    ASSERT(std::get<0>(b) == rpc_core::detail::string_view("name"));
+    ASSERT(std::get<0>(b).data() >= data.data() && std::get<0>(b).data() < data.data() + data.size());
+    ASSERT(std::get<1>(b).size() == 2);
+    ASSERT(std::get<1>(b)[1] == 2.f);
+    ASSERT(std::get<1>(b).to_vector() == std::get<1>(a));
+    // same wire format
+    ASSERT(rpc_core::serialize(b) == data);
+  }
+
+  /// length prefix of nested items is written in place, shift when it is not 2 bytes
+  {
+    RPC_CORE_LOGI("nested size prefix...");
+    std::vector<std::string> a{"", std::string(300, 'a'), std::string(70000, 'b')};
+    std::vector<std::string> b;
+    serialize_test(a, b);
+    ASSERT(a == b);
+    ASSERT_SERIALIZE_SIZE((2) + (1) + (3 + 300) + (4 + 70000));
+
+    // size unknown ahead, the prefix is fixed after writing the item
+    std::vector<NoSizeString> c{{a[0]}, {a[1]}, {a[2]}};
+    std::vector<NoSizeString> d;
+    serialize_test(c, d);
+    ASSERT(!last_size_known);
+    ASSERT(rpc_core::serialize(c) == rpc_core::serialize(a));
+    ASSERT(d.size() == 3 && d[2].data == a[2]);
+  }
+
+  /// pod on wire struct is copied as a whole, same wire format as field by field
+  {
+    RPC_CORE_LOGI("custom type(pod on wire)...");
+    CustomTypePod a{-1, 2, 3.f, 4.0};
+    CustomTypePod b;
+    serialize_test(a, b);
+    ASSERT(a == b);
+    ASSERT_SERIALIZE_SIZE(sizeof(CustomTypePod));
+    ASSERT(rpc_core::serialize(a) == rpc_core::serialize(std::make_tuple(a.a, a.b, a.c, a.d)));
+
+    std::vector<CustomTypePod> va{a, CustomTypePod{5, 6, 7.f, 8.0}};
+    std::vector<CustomTypePod> vb;
+    serialize_test(va, vb);
+    ASSERT(va == vb);
+    std::list<CustomTypePod> la(va.begin(), va.end());
+    ASSERT(rpc_core::serialize(va) == rpc_core::serialize(la));
+    std::vector<CustomTypePod> vc;
+    ASSERT(rpc_core::deserialize(rpc_core::serialize(la), vc) && va == vc);
+  }
+
+  /// tagged fields are matched by tag, unknown fields are skipped
+  {
+    RPC_CORE_LOGI("custom type(tagged)...");
+    test::CustomTypeTaggedV2 a;
+    a.name = "v2";
+    a.flag = true;
+    a.id = 123;
+    a.score = 1.5;
+    a.custom.ids = {1, 2};
+    a.count = -1;
+    test::CustomTypeTaggedV2 b;
+    serialize_test(a, b);
+    ASSERT(b.name == a.name && b.flag && b.id == a.id && b.score == a.score && b.custom == a.custom && b.count == a.count);
+    // key: 1 byte for tag < 16, 2 bytes for tag 200
+    ASSERT_SERIALIZE_SIZE((1 + 2 + 2) + (1 + 1) + (1 + 2) + (1 + 8) + (1 + 2 + (1 + (2 + 6) + 1)) + (2 + 2));
+
+    // new -> old: skip unknown fields
+    test::CustomTypeTaggedV1 v1;
+    ASSERT(rpc_core::deserialize(rpc_core::serialize(a), v1));
+    ASSERT(v1.id == 123 && v1.name == "v2");
+
+    // old -> new: missing fields keep default
+    test::CustomTypeTaggedV2 v2;
+    ASSERT(rpc_core::deserialize(rpc_core::serialize(v1), v2));
+    ASSERT(v2.id == 123 && v2.name == "v2" && !v2.flag && v2.count == 0);
+
+    // field type changed
+    auto data = rpc_core::serialize(v1);
+    data[0] = (char)((1 << 3) | rpc_core::detail::tagged_fixed8);
+    ASSERT(!rpc_core::deserialize(data, v2));
+  }
+
+  /// arena containers are same as std containers on wire, and allocate from the arena of current scope
+  {
+    RPC_CORE_LOGI("arena containers...");
+    std::map<std::string, std::vector<std::string>> a{{"k1", {"a", std::string(100, 'b')}}, {"k2", {}}};
+    auto data = rpc_core::serialize(a);
+    rpc_core::arena arena(1024);
+    {
+      rpc_core::arena::scope scope(&arena);
+      rpc_core::arena_map<rpc_core::arena_string, rpc_core::arena_vector<rpc_core::arena_string>> b;
+      ASSERT(rpc_core::deserialize(data, b));
+      ASSERT(b.size() == 2);
+      ASSERT(b.begin()->first == "k1");
+      ASSERT(b.begin()->second[1] == rpc_core::arena_string(100, 'b'));
+      ASSERT(rpc_core::serialize(b) == data);
+      ASSERT(arena.block_count() == 1);
+    }
+    ASSERT(rpc_core::arena::current() == nullptr);
+    // reset and reuse blocks
+    {
+      rpc_core::arena::scope scope(&arena);
+      rpc_core::arena_vector<rpc_core::arena_string> b;
+      ASSERT(rpc_core::deserialize(rpc_core::serialize(a.begin()->second), b));
+      ASSERT(b[0] == "a");
+      ASSERT(arena.block_count() == 1);
+    }
+  }
 }
 
 }  // namespace rpc_core_test
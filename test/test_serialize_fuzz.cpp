@@ -0,0 +1,108 @@
+#include <vector>
+
+#include "assert_def.h"
+#include "rpc_core.hpp"
+#include "serialize/CustomType.h"
+
+namespace rpc_core_test {
+
+static uint32_t fuzz_seed = 1;
+
+static uint32_t fuzz_rand() {
+  fuzz_seed = fuzz_seed * 1103515245 + 12345;
+  return fuzz_seed >> 8;
+}
+
+/**
+ * Deserialize truncated and mutated data, it should fail or succeed without reading past the input.
+ * Input is copied into an exact-size buffer, so sanitizers catch out of bounds reads.
+ */
+template <typename T>
+static void fuzz_deserialize(const T& sample) {
+  const std::string data = rpc_core::serialize(sample);
+  {
+    T out;
+    ASSERT(rpc_core::deserialize(data, out));
+  }
+
+  for (size_t len = 0; len < data.size(); ++len) {
+    std::vector<char> input(data.data(), data.data() + len);
+    T out;
+    rpc_core::deserialize(rpc_core::detail::string_view(input.data(), input.size()), out);
+  }
+
+  for (int i = 0; i < 200 && !data.empty(); ++i) {
+    std::vector<char> input(data.begin(), data.end());
+    const uint32_t mutations = 1 + fuzz_rand() % 3;
+    for (uint32_t m = 0; m < mutations; ++m) {
+      input[fuzz_rand() % input.size()] = (char)fuzz_rand();
+    }
+    input.resize(input.size() - fuzz_rand() % 2);
+    T out;
+    rpc_core::deserialize(rpc_core::detail::string_view(input.data(), input.size()), out);
+  }
+}
+
+enum class FuzzEnum : uint8_t {
+  A = 1,
+  B = 200,
+};
+
+void test_serialize_fuzz() {
+  CustomType custom;
+  custom.id = 0x12345678;
+  custom.ids = {1, 0x7fffffff, 3};
+  custom.name = "custom";
+
+  CustomTypePtr custom_ptr;
+  custom_ptr.int_v = (int32_t*)1;
+  custom_ptr.unique_ptr_v = std::unique_ptr<int32_t>(new int32_t(1));
+  custom_ptr.shared_ptr_v = std::make_shared<int32_t>(2);
+
+  test::CustomTypeNest nest;
+  nest.c2.id1 = 1;
+  nest.c3.id2 = 2;
+
+  RPC_CORE_LOGI("fuzz raw types...");
+  fuzz_deserialize(int32_t(-123456));
+  fuzz_deserialize(uint64_t(0x123456789abcdefULL));
+  fuzz_deserialize(3.14);
+  fuzz_deserialize(FuzzEnum::B);
+
+  RPC_CORE_LOGI("fuzz containers...");
+  fuzz_deserialize(std::string("hello"));
+  fuzz_deserialize(std::vector<int>{1, -2, 300000});
+  fuzz_deserialize(std::vector<float>{1.f, 2.f, 3.f});
+  fuzz_deserialize(std::vector<std::string>{"a", "", "ccc"});
+  fuzz_deserialize(std::list<CustomType>{custom, custom});
+  fuzz_deserialize(std::deque<uint16_t>{1, 2});
+  fuzz_deserialize(std::forward_list<int>{1, 2, 3});
+  fuzz_deserialize(std::array<uint8_t, 4>{{1, 2, 3, 4}});
+  fuzz_deserialize(std::array<std::string, 2>{{"a", "b"}});
+  fuzz_deserialize(std::set<int>{1, 2, 3});
+  fuzz_deserialize(std::map<std::string, std::vector<int>>{{"a", {1}}, {"b", {2, 3}}});
+  fuzz_deserialize(std::unordered_map<int, std::string>{{1, "a"}, {2, "b"}});
+
+  RPC_CORE_LOGI("fuzz misc types...");
+  fuzz_deserialize(std::make_tuple(true, 1, std::string("t"), custom));
+  fuzz_deserialize(std::make_pair(std::string("k"), 1.5));
+  fuzz_deserialize(std::bitset<8>(0x5a));
+  fuzz_deserialize(std::chrono::milliseconds(123456));
+  fuzz_deserialize(std::complex<double>(1, 2));
+  fuzz_deserialize(std::make_shared<std::string>("shared"));
+
+  RPC_CORE_LOGI("fuzz custom types...");
+  fuzz_deserialize(custom);
+  fuzz_deserialize(custom_ptr);
+  fuzz_deserialize(nest);
+  fuzz_deserialize(std::vector<CustomTypePod>{CustomTypePod{1, 2, 3.f, 4.0}, CustomTypePod{}});
+
+  test::CustomTypeTaggedV2 tagged;
+  tagged.name = "tagged";
+  tagged.custom = custom;
+  tagged.count = 1 << 20;
+  fuzz_deserialize(tagged);
+  fuzz_deserialize(std::vector<test::CustomTypeTaggedV2>{tagged, tagged});
+}
+
+}  // namespace rpc_core_test